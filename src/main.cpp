@@ -2,12 +2,326 @@
 #include <iostream>
 #include <cassert>
 #include <vector>
+#include <string>
+#include <tuple>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <span>
+#include <functional>
+#include <type_traits>
+#include <cstring>
+#include <climits>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <future>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <condition_variable>
+#include <memory_resource>
+
+// x86 SIMD kernels are compiled per function with target attributes and
+// picked at run time, so the binary still runs on CPUs without AVX2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ALGOS_X86_SIMD 1
+#define ALGOS_AVX2 __attribute__((target("avx2")))
+#define ALGOS_AVX512 __attribute__((target("avx512f")))
+#include <immintrin.h>
+#else
+#define ALGOS_X86_SIMD 0
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 using namespace std;
 
+// Operations whose latency can be recorded, plus the hash table probe-length
+// distribution, which shares the same histogram machinery
+enum class TimedOperation { HashInsert, HashLookup, HashDelete, Enqueue, Dequeue, Push, Pop, HashProbes, Count };
+
+// Default latency policy: Scope is an empty object and nothing is recorded
+struct NoLatency {
+    static constexpr bool enabled = false;
+    struct Scope {
+        explicit Scope(TimedOperation) {}
+    };
+    static void countProbe() {}
+};
+
+// Log-linear histogram in the style of HdrHistogram: values below 32 get a
+// bucket each, and every power of two above that is split into 16 linear
+// buckets, so any recorded value is known to within about 6%
+class LatencyHistogram {
+public:
+    static constexpr int subBucketBits = 5;
+    static constexpr int halfCount = 1 << (subBucketBits - 1);
+    static constexpr uint64_t maxTrackable = (uint64_t(1) << 40) - 1;
+    static constexpr int bucketCount = (40 - subBucketBits) * halfCount + 2 * halfCount;
+
+    static int bucketOf(uint64_t value) {
+        value = std::min(value, maxTrackable);
+        int shift = std::max(0, int(bit_width(value)) - subBucketBits);
+        return shift * halfCount + int(value >> shift);
+    }
+
+    // Highest value that falls into the bucket
+    static uint64_t bucketUpper(int bucket) {
+        if (bucket < 2 * halfCount) return uint64_t(bucket);
+        int shift = bucket / halfCount - 1;
+        uint64_t mantissa = uint64_t(bucket - shift * halfCount);
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void add(int bucket, uint64_t n) {
+        counts[bucket] += n;
+        total += n;
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    uint64_t countAt(int bucket) const {
+        return counts[bucket];
+    }
+
+    // Smallest bucket bound that covers the fraction p of all recorded values
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(ceil(p * double(total))));
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < bucketCount; bucket++) {
+            seen += counts[bucket];
+            if (seen >= rank) return bucketUpper(bucket);
+        }
+        return maxTrackable;
+    }
+
+    uint64_t maxValue() const {
+        for (int bucket = bucketCount - 1; bucket >= 0; bucket--) {
+            if (counts[bucket] != 0) return bucketUpper(bucket);
+        }
+        return 0;
+    }
+
+private:
+    array<uint64_t, bucketCount> counts{};
+    uint64_t total = 0;
+};
+
+// Latency policy that times each operation with rdtsc (steady_clock off x86)
+// into per-thread histograms. Only the owning thread writes its counters, so
+// recording is a relaxed load and store with no locking; snapshot() merges
+// every thread's histograms while they keep running. A thread that exits
+// folds its counts into one shared set, so memory does not grow with the
+// number of threads that have come and gone.
+class LatencyRecorder {
+public:
+    static constexpr bool enabled = true;
+    static constexpr int operationCount = int(TimedOperation::Count);
+
+    struct Snapshot {
+        array<LatencyHistogram, operationCount> histograms;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(TimedOperation op) : op(op), start(ticks()) {
+            pendingProbes = 0;
+        }
+
+        ~Scope() {
+            uint64_t elapsed = ticks() - start;
+            ThreadHistograms& local = threadHistograms();
+            record(local, op, elapsed);
+            if (op <= TimedOperation::HashDelete) {
+                record(local, TimedOperation::HashProbes, uint64_t(pendingProbes));
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TimedOperation op;
+        uint64_t start;
+    };
+
+    // Called by the hash table for every probe of the operation in progress
+    static void countProbe() {
+        pendingProbes++;
+    }
+
+    static Snapshot snapshot() {
+        Snapshot merged;
+        lock_guard<mutex> lock(registryLock);
+        for (int op = 0; op < operationCount; op++) {
+            for (int bucket = 0; bucket < LatencyHistogram::bucketCount; bucket++) {
+                if (retired[op][bucket] != 0) merged.histograms[op].add(bucket, retired[op][bucket]);
+            }
+        }
+        for (const ThreadHistograms* thread : registry) {
+            for (int op = 0; op < operationCount; op++) {
+                for (int bucket = 0; bucket < LatencyHistogram::bucketCount; bucket++) {
+                    uint64_t n = thread->counts[op][bucket].load(memory_order_relaxed);
+                    if (n != 0) merged.histograms[op].add(bucket, n);
+                }
+            }
+        }
+        return merged;
+    }
+
+    static double ticksPerNanosecond() {
+#if ALGOS_X86_SIMD
+        // Assumes an invariant TSC; the rate is measured against steady_clock
+        // since the program started, waiting a little if that was very recent
+        auto elapsed = chrono::steady_clock::now() - origin.first;
+        while (elapsed < chrono::milliseconds(10)) {
+            this_thread::yield();
+            elapsed = chrono::steady_clock::now() - origin.first;
+        }
+        uint64_t tickSpan = ticks() - origin.second;
+        return double(tickSpan) / double(chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+#else
+        return 1.0;
+#endif
+    }
+
+    // One line of percentiles per operation that has been recorded, and the
+    // probe-length distribution of the hash table
+    static void report(ostream& out) {
+        static const char* names[] = { "hashInsert", "hashLookup", "hashDelete", "enqueue", "dequeue", "push", "pop" };
+        Snapshot merged = snapshot();
+        double scale = 1.0 / ticksPerNanosecond();
+        for (int op = 0; op < int(TimedOperation::HashProbes); op++) {
+            const LatencyHistogram& h = merged.histograms[op];
+            if (h.count() == 0) continue;
+            out << "[latency] " << names[op] << " n=" << h.count()
+                << " p50=" << uint64_t(double(h.percentile(0.50)) * scale) << "ns"
+                << " p99=" << uint64_t(double(h.percentile(0.99)) * scale) << "ns"
+                << " p999=" << uint64_t(double(h.percentile(0.999)) * scale) << "ns"
+                << " max=" << uint64_t(double(h.maxValue()) * scale) << "ns" << endl;
+        }
+        const LatencyHistogram& probes = merged.histograms[int(TimedOperation::HashProbes)];
+        if (probes.count() != 0) {
+            out << "[latency] hashProbes n=" << probes.count() << " p50=" << probes.percentile(0.50)
+                << " p99=" << probes.percentile(0.99) << " max=" << probes.maxValue() << " distribution:";
+            uint64_t longer = probes.count();
+            for (int length = 0; length < 8; length++) {
+                longer -= probes.countAt(length);
+                if (probes.countAt(length) != 0) out << " " << length << ":" << probes.countAt(length);
+            }
+            if (longer != 0) out << " >7:" << longer;
+            out << endl;
+        }
+    }
+
+private:
+    struct ThreadHistograms {
+        array<array<atomic<uint64_t>, LatencyHistogram::bucketCount>, operationCount> counts{};
+    };
+
+    static uint64_t ticks() {
+#if ALGOS_X86_SIMD
+        return __rdtsc();
+#else
+        return uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static void record(ThreadHistograms& local, TimedOperation op, uint64_t value) {
+        atomic<uint64_t>& counter = local.counts[int(op)][LatencyHistogram::bucketOf(value)];
+        counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+
+    // A thread's histograms, registered on first use. When the thread exits
+    // they are added to retired and leave the registry, so their samples
+    // still show up in later snapshots.
+    class ThreadSlot {
+    public:
+        ThreadSlot() : histograms(make_unique<ThreadHistograms>()) {
+            lock_guard<mutex> lock(registryLock);
+            registry.push_back(histograms.get());
+        }
+
+        ~ThreadSlot() {
+            lock_guard<mutex> lock(registryLock);
+            for (int op = 0; op < operationCount; op++) {
+                for (int bucket = 0; bucket < LatencyHistogram::bucketCount; bucket++) {
+                    retired[op][bucket] += histograms->counts[op][bucket].load(memory_order_relaxed);
+                }
+            }
+            registry.erase(find(registry.begin(), registry.end(), histograms.get()));
+        }
+
+        ThreadSlot(const ThreadSlot&) = delete;
+        ThreadSlot& operator=(const ThreadSlot&) = delete;
+
+        unique_ptr<ThreadHistograms> histograms;
+    };
+
+    static ThreadHistograms& threadHistograms() {
+        thread_local ThreadSlot slot;
+        return *slot.histograms;
+    }
+
+    static inline thread_local int pendingProbes = 0;
+    static inline mutex registryLock;
+    static inline vector<ThreadHistograms*> registry; // Threads still running
+    // Counts of the threads that have exited, guarded by registryLock
+    static inline array<array<uint64_t, LatencyHistogram::bucketCount>, operationCount> retired{};
+    static inline const pair<chrono::steady_clock::time_point, uint64_t> origin{ chrono::steady_clock::now(), ticks() };
+};
+
+// Calls LatencyRecorder::report on a background thread every interval until
+// stopped, while the recorded data structures keep running
+class LatencyReporter {
+public:
+    LatencyReporter(ostream& out, chrono::milliseconds interval) : stopping(false) {
+        worker = thread([this, &out, interval] {
+            unique_lock<mutex> lock(stateLock);
+            while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+                LatencyRecorder::report(out);
+            }
+        });
+    }
+
+    ~LatencyReporter() {
+        stop();
+    }
+
+    LatencyReporter(const LatencyReporter&) = delete;
+    LatencyReporter& operator=(const LatencyReporter&) = delete;
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(stateLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+private:
+    mutex stateLock;
+    condition_variable wake;
+    bool stopping;
+    thread worker;
+};
+
 const int maxStackSize = 100;  // Maximum size of the stack
 
-template <class StackElementType>
+template <class StackElementType, class Latency = NoLatency>
 class Stack {
 public:
     Stack();  // Constructor
@@ -23,14 +337,15 @@ private:
 };
 
 // Constructor
-template <class StackElementType>
-Stack<StackElementType>::Stack() {
+template <class StackElementType, class Latency>
+Stack<StackElementType, Latency>::Stack() {
     topIndex = -1;  // Initialize topIndex to -1 (empty stack)
 }
 
 // Push operation
-template <class StackElementType>
-void Stack<StackElementType>::push(StackElementType item) {
+template <class StackElementType, class Latency>
+void Stack<StackElementType, Latency>::push(StackElementType item) {
+    typename Latency::Scope timed(TimedOperation::Push);
     ++topIndex;
     // Ensure array bounds are not exceeded
     assert(topIndex < maxStackSize);
@@ -38,8 +353,9 @@ void Stack<StackElementType>::push(StackElementType item) {
 }
 
 // Pop operation
-template <class StackElementType>
-StackElementType Stack<StackElementType>::pop() {
+template <class StackElementType, class Latency>
+StackElementType Stack<StackElementType, Latency>::pop() {
+    typename Latency::Scope timed(TimedOperation::Pop);
     // Ensure array bounds are not exceeded
     assert(topIndex >= 0);
     int returnIndex = topIndex;
@@ -48,30 +364,511 @@ StackElementType Stack<StackElementType>::pop() {
 }
 
 // Top operation
-template <class StackElementType>
-StackElementType Stack<StackElementType>::top() {
+template <class StackElementType, class Latency>
+StackElementType Stack<StackElementType, Latency>::top() {
     // Ensure array bounds are not exceeded
     assert(topIndex >= 0);
     return stackArray[topIndex];
 }
 
 // Check if the stack is empty
-template <class StackElementType>
-bool Stack<StackElementType>::isEmpty() {
+template <class StackElementType, class Latency>
+bool Stack<StackElementType, Latency>::isEmpty() {
     return (topIndex == -1);
 }
 
 // Check if the stack is full
-template <class StackElementType>
-bool Stack<StackElementType>::isFull() {
+template <class StackElementType, class Latency>
+bool Stack<StackElementType, Latency>::isFull() {
     return (topIndex == maxStackSize - 1);
 }
 
 
+// Owning array whose storage is cache-line aligned. Buffers of 2 MiB or more
+// are aligned to 2 MiB and flagged for transparent huge pages, which cuts TLB
+// misses when large inputs are scanned over and over. Given a memory_resource,
+// the storage comes from it instead (still cache-line or 2 MiB aligned).
+template <class T>
+class AlignedBuffer {
+public:
+    static const size_t cacheLine = 64;
+    static const size_t hugePage = size_t(2) << 20;
+
+    AlignedBuffer() : ptr(nullptr), count(0), alignment(cacheLine), resource(nullptr) {}
+
+    explicit AlignedBuffer(size_t elements, pmr::memory_resource* resource = nullptr)
+        : ptr(nullptr), count(elements), alignment(cacheLine), resource(resource) {
+        if (count == 0) return;
+        size_t bytes = allocatedBytes();
+        if (resource != nullptr) {
+            ptr = static_cast<T*>(resource->allocate(bytes, alignment));
+            return;
+        }
+        ptr = static_cast<T*>(::operator new(bytes, align_val_t(alignment)));
+#ifdef __linux__
+        if (alignment == hugePage) madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : ptr(other.ptr), count(other.count), alignment(other.alignment), resource(other.resource) {
+        other.ptr = nullptr;
+        other.count = 0;
+    }
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            ptr = other.ptr;
+            count = other.count;
+            alignment = other.alignment;
+            resource = other.resource;
+            other.ptr = nullptr;
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    ~AlignedBuffer() { release(); }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+private:
+    T* ptr;                         // Start of the aligned storage
+    size_t count;                   // Number of elements
+    size_t alignment;               // Alignment the storage was allocated with
+    pmr::memory_resource* resource; // Where the storage came from, nullptr for operator new
+
+    // Size rounded up to whole alignment units; picks the alignment first
+    size_t allocatedBytes() {
+        size_t bytes = count * sizeof(T);
+        if (bytes >= hugePage) alignment = hugePage;
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    void release() {
+        if (ptr == nullptr) return;
+        if (resource != nullptr) {
+            resource->deallocate(ptr, allocatedBytes(), alignment);
+        } else {
+            ::operator delete(ptr, align_val_t(alignment));
+        }
+        ptr = nullptr;
+    }
+};
+
+
+// Shapes of input the generator can produce
+enum class Distribution {
+    Uniform,      // Independent values spread evenly over [minimum_num, maximum_num]
+    Zipf,         // Skewed values: minimum_num is the most frequent, then minimum_num + 1, ...
+    Sorted,       // Uniform values in ascending order
+    NearlySorted, // Sorted, then a fraction of elements swapped with a nearby element
+    FewUnique,    // Only a handful of distinct values
+    Adversarial   // Drives median-of-three quicksort to quadratic time
+};
+
+// Settings for DataGenerator
+struct GeneratorOptions {
+    Distribution distribution = Distribution::Uniform;
+    int minimum_num = 0;
+    int maximum_num = 100;
+    uint64_t seed = 0;
+    int threads = 0;            // Worker threads, 0 = one per hardware thread
+    double zipfExponent = 1.0;  // Skew of the Zipf distribution
+    double disorder = 0.01;     // NearlySorted: fraction of elements displaced
+    int uniqueValues = 8;       // FewUnique: number of distinct values
+};
+
+// High 64 bits of the 128-bit product a * b
+inline uint64_t multiplyHigh(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    return uint64_t((unsigned __int128)a * b >> 64);
+#else
+    // Schoolbook multiplication on 32-bit halves
+    uint64_t aLow = a & 0xFFFFFFFFu, aHigh = a >> 32;
+    uint64_t bLow = b & 0xFFFFFFFFu, bHigh = b >> 32;
+    uint64_t lowLow = aLow * bLow;
+    uint64_t highLow = aHigh * bLow;
+    uint64_t lowHigh = aLow * bHigh;
+    uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFFu) + lowHigh;
+    return aHigh * bHigh + (highLow >> 32) + (cross >> 32);
+#endif
+}
+
+// Test data generator. Random numbers come from SplitMix64 evaluated at a
+// counter: the i-th number of a stream depends only on (seed, stream, i), so
+// threads fill disjoint slices independently and the output for a seed is the
+// same whatever the thread count.
+class DataGenerator {
+public:
+    // Allocate an aligned buffer (from resource when one is given) and fill it
+    static AlignedBuffer<int> generate(int size, const GeneratorOptions& options, pmr::memory_resource* resource = nullptr) {
+        AlignedBuffer<int> buffer(size > 0 ? size : 0, resource);
+        fill(buffer.data(), size, options);
+        return buffer;
+    }
+
+    // Fill an existing array; returns false on invalid parameters
+    static bool fill(int arr[], int size, const GeneratorOptions& options) {
+        if (size <= 0 || options.minimum_num > options.maximum_num) {
+            cerr << "Invalid parameters for random array generation!" << endl;
+            return false;
+        }
+        uint64_t range = uint64_t(int64_t(options.maximum_num) - options.minimum_num) + 1;
+        uint64_t key = mix(options.seed);
+        int minimum_num = options.minimum_num;
+
+        switch (options.distribution) {
+            case Distribution::Uniform:
+                parallelFor(size, options.threads, [&](int i) {
+                    arr[i] = offset(minimum_num, bounded(random(key, 0, i), range));
+                });
+                break;
+
+            case Distribution::Zipf: {
+                ZipfSampler zipf(range, options.zipfExponent);
+                parallelFor(size, options.threads, [&](int i) {
+                    arr[i] = offset(minimum_num, zipf.sample(key, i) - 1);
+                });
+                break;
+            }
+
+            case Distribution::Sorted:
+            case Distribution::NearlySorted:
+                parallelFor(size, options.threads, [&](int i) {
+                    arr[i] = offset(minimum_num, bounded(random(key, 0, i), range));
+                });
+                std::sort(arr, arr + size);
+                if (options.distribution == Distribution::NearlySorted) {
+                    // Swap a few elements with a neighbour at most 8 positions away
+                    long swaps = long(options.disorder * size);
+                    for (long s = 0; s < swaps; s++) {
+                        int i = int(bounded(random(key, 1, s), size));
+                        int j = i + 1 + int(bounded(random(key, 2, s), 8));
+                        if (j < size) std::swap(arr[i], arr[j]);
+                    }
+                }
+                break;
+
+            case Distribution::FewUnique: {
+                int unique = options.uniqueValues > 0 ? options.uniqueValues : 1;
+                vector<int> values(unique);
+                for (int v = 0; v < unique; v++) {
+                    values[v] = offset(minimum_num, bounded(random(key, 3, v), range));
+                }
+                parallelFor(size, options.threads, [&](int i) {
+                    arr[i] = values[bounded(random(key, 4, i), unique)];
+                });
+                break;
+            }
+
+            case Distribution::Adversarial:
+                antiQuickSort(arr, size);
+                // Scale the ranks 0..size-1 onto the requested range (order preserving)
+                for (int i = 0; i < size; i++) {
+                    arr[i] = offset(minimum_num, uint64_t(arr[i]) * range / uint64_t(size));
+                }
+                break;
+        }
+        return true;
+    }
+
+private:
+    // SplitMix64 output function
+    static uint64_t mix(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // The index-th number of the given stream
+    static uint64_t random(uint64_t key, uint64_t stream, uint64_t index) {
+        return mix(key ^ mix(stream) ^ (index * 0xD1B54A32D192ED03ull));
+    }
+
+    // Map a 64-bit random number onto [0, range) without modulo bias
+    // (Lemire's multiply-shift; the remaining bias is below range / 2^64)
+    static uint64_t bounded(uint64_t r, uint64_t range) {
+        return multiplyHigh(r, range);
+    }
+
+    // minimum_num + delta, computed wide so full-range requests don't overflow
+    static int offset(int minimum_num, uint64_t delta) {
+        return int(int64_t(minimum_num) + int64_t(delta));
+    }
+
+    // Uniform double in [0, 1)
+    static double unit(uint64_t r) {
+        return double(r >> 11) * 0x1.0p-53;
+    }
+
+    // Run body(i) for i in [0, size), split into contiguous slices over worker threads
+    template <class Body>
+    static void parallelFor(int size, int threads, Body body) {
+        const int minSlice = 1 << 16; // Not worth a thread below this
+        if (threads <= 0) threads = int(thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, size / minSlice));
+
+        auto runSlice = [&](int t) {
+            int begin = int(int64_t(size) * t / threads);
+            int end = int(int64_t(size) * (t + 1) / threads);
+            for (int i = begin; i < end; i++) body(i);
+        };
+
+        vector<thread> workers;
+        for (int t = 1; t < threads; t++) workers.emplace_back(runSlice, t);
+        runSlice(0);
+        for (thread& worker : workers) worker.join();
+    }
+
+    // Zipf sampling over ranks 1..n by rejection-inversion
+    // (Hormann & Derflinger), usually accepting on the first draw.
+    class ZipfSampler {
+    public:
+        ZipfSampler(uint64_t n, double exponent) : n(double(n)), s(exponent) {
+            hIntegralX1 = hIntegral(1.5) - 1.0;
+            hIntegralN = hIntegral(this->n + 0.5);
+            threshold = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+        }
+
+        uint64_t sample(uint64_t key, uint64_t index) const {
+            for (uint64_t attempt = 0;; attempt++) {
+                double u = hIntegralN + unit(random(key, 5 + attempt, index)) * (hIntegralX1 - hIntegralN);
+                double x = hIntegralInverse(u);
+                double k = std::floor(x + 0.5);
+                if (k < 1.0) k = 1.0;
+                if (k > n) k = n;
+                if (k - x <= threshold || u >= hIntegral(k + 0.5) - h(k)) {
+                    return uint64_t(k);
+                }
+            }
+        }
+
+    private:
+        double n, s;
+        double hIntegralX1, hIntegralN, threshold;
+
+        double h(double x) const { return std::exp(-s * std::log(x)); }
+
+        double hIntegral(double x) const {
+            double logX = std::log(x);
+            return helper2((1.0 - s) * logX) * logX;
+        }
+
+        double hIntegralInverse(double x) const {
+            double t = x * (1.0 - s);
+            if (t < -1.0) t = -1.0;
+            return std::exp(helper1(t) * x);
+        }
+
+        // log1p(x) / x, accurate near 0
+        static double helper1(double x) {
+            return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+        }
+
+        // expm1(x) / x, accurate near 0
+        static double helper2(double x) {
+            return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+        }
+    };
+
+    // McIlroy's "killer adversary": run a median-of-three quicksort with a
+    // comparator that fixes element values lazily, always in the way that makes
+    // the current pivot the smallest candidate. The frozen values are an input
+    // on which that quicksort takes quadratic time. Writes ranks 0..size-1 to arr.
+    // Only about one element is frozen per partition and the rest compare
+    // greater than the pivot without moving, so the simulated scans visit just
+    // the frozen positions and generating takes O(size) time.
+    static void antiQuickSort(int arr[], int size) {
+        const int gas = size; // Not yet decided, larger than every frozen value
+        vector<int> val(size, gas);
+        vector<int> order(size);
+        for (int i = 0; i < size; i++) order[i] = i;
+        int frozen = 0;
+        int candidate = 0;
+
+        auto less = [&](int x, int y) {
+            if (val[x] == gas && val[y] == gas) {
+                if (x == candidate) val[x] = frozen++;
+                else val[y] = frozen++;
+            }
+            if (val[x] == gas) candidate = x;
+            else if (val[y] == gas) candidate = y;
+            return val[x] < val[y];
+        };
+        auto isFrozen = [&](int pos) { return val[order[pos]] != gas; };
+
+        // Positions of the frozen elements of the range being partitioned, ascending.
+        // Gas elements compare greater than the (frozen) pivot and are never
+        // moved by the scan, so only these positions need visiting.
+        struct Range { int low, high; vector<int> frozenAt; };
+        Range range{0, size - 1, {}};
+        vector<Range> pending; // Smaller halves are handled later
+        vector<int> touched;
+        while (true) {
+            int low = range.low, high = range.high;
+            if (low < high) {
+                vector<int>& frozenAt = range.frozenAt;
+                // Median of three moved to high; this always leaves a frozen pivot
+                int mid = low + (high - low) / 2;
+                if (less(order[mid], order[low])) std::swap(order[mid], order[low]);
+                if (less(order[high], order[low])) std::swap(order[high], order[low]);
+                if (less(order[mid], order[high])) std::swap(order[mid], order[high]);
+                int pivot = order[high];
+
+                // The last gas element the scan compares becomes the next candidate
+                for (int j = high - 1; j >= low; j--) {
+                    if (!isFrozen(j)) {
+                        candidate = order[j];
+                        break;
+                    }
+                }
+
+                // Lomuto scan over the frozen positions only
+                touched.assign({low, mid, high});
+                int i = low - 1;
+                for (int j : frozenAt) {
+                    if (j == low || j == mid || j >= high) continue;
+                    touched.push_back(j);
+                }
+                ranges::sort(touched);
+                touched.erase(ranges::unique(touched).begin(), touched.end());
+                for (int j : touched) {
+                    if (j < high && isFrozen(j) && val[order[j]] <= val[pivot]) std::swap(order[++i], order[j]);
+                }
+                std::swap(order[i + 1], order[high]);
+                int pi = i + 1;
+
+                // Everything that moved is in [low, pi] or in touched
+                for (int p = low; p <= pi; p++) touched.push_back(p);
+                ranges::sort(touched);
+                touched.erase(ranges::unique(touched).begin(), touched.end());
+                Range left{low, pi - 1, {}}, right{pi + 1, high, {}};
+                for (int p : touched) {
+                    if (!isFrozen(p)) continue;
+                    if (p < pi) left.frozenAt.push_back(p);
+                    else if (p > pi) right.frozenAt.push_back(p);
+                }
+                // Continue with the larger side so the pending stack stays small
+                if (pi - low < high - pi) {
+                    pending.push_back(std::move(left));
+                    range = std::move(right);
+                } else {
+                    pending.push_back(std::move(right));
+                    range = std::move(left);
+                }
+            } else if (!pending.empty()) {
+                range = std::move(pending.back());
+                pending.pop_back();
+            } else {
+                break;
+            }
+        }
+
+        for (int i = 0; i < size; i++) {
+            if (val[i] == gas) val[i] = frozen++;
+            arr[i] = val[i];
+        }
+    }
+};
+
+// Operations the instrumented algorithms can count
+enum class Operation { Comparison, Swap, Move, Allocation, Probe, Count };
+
+// Instrumentation policies. Algorithms and containers take one as a template
+// parameter and report events through Instrumentation::count(...).
+// NoInstrumentation is the default: count() is an empty inline function, so
+// release code carries no counters at all.
+struct NoInstrumentation {
+    static constexpr bool enabled = false;
+    static void count(Operation, long = 1) {}
+};
+
+// Counts every reported event in per-thread counters
+struct OperationCounters {
+    static constexpr bool enabled = true;
+    static inline thread_local array<long, size_t(Operation::Count)> current{};
+
+    static void count(Operation op, long n = 1) {
+        current[size_t(op)] += n;
+    }
+
+    static void reset() {
+        current.fill(0);
+    }
+};
+
+// Collects OperationCounters per profile() run, grouped by name, and writes
+// them out as JSON. A run is whatever its body does, which may be several
+// calls of the algorithm:
+//   { "quickSort": { "runs": 2, "total": {...}, "perRun": [{...}, {...}] }, ... }
+class OperationProfiler {
+public:
+    using Counts = array<long, size_t(Operation::Count)>;
+
+    // Run body with fresh counters and record what it counted under name
+    template <class Body>
+    void profile(const string& name, Body&& body) {
+        OperationCounters::reset();
+        body();
+        Counts counts = OperationCounters::current;
+        auto it = find_if(profiles.begin(), profiles.end(), [&](const auto& p) { return p.first == name; });
+        if (it == profiles.end()) {
+            profiles.push_back({ name, {} });
+            it = profiles.end() - 1;
+        }
+        it->second.push_back(counts);
+    }
+
+    void exportJson(ostream& out) const {
+        out << "{" << endl;
+        for (size_t p = 0; p < profiles.size(); p++) {
+            const auto& runs = profiles[p].second;
+            Counts total{};
+            for (const Counts& run : runs) {
+                for (size_t op = 0; op < total.size(); op++) total[op] += run[op];
+            }
+            out << "  \"" << profiles[p].first << "\": {\"runs\": " << runs.size() << ", \"total\": ";
+            writeCounts(out, total);
+            out << ", \"perRun\": [";
+            for (size_t r = 0; r < runs.size(); r++) {
+                if (r > 0) out << ", ";
+                writeCounts(out, runs[r]);
+            }
+            out << "]}" << (p + 1 < profiles.size() ? "," : "") << endl;
+        }
+        out << "}" << endl;
+    }
+
+private:
+    vector<pair<string, vector<Counts>>> profiles; // In first-profiled order
+
+    static void writeCounts(ostream& out, const Counts& counts) {
+        static const char* names[] = { "comparisons", "swaps", "moves", "allocations", "probes" };
+        out << "{";
+        for (size_t op = 0; op < counts.size(); op++) {
+            out << (op > 0 ? ", " : "") << "\"" << names[op] << "\": " << counts[op];
+        }
+        out << "}";
+    }
+};
+
+
 // Helper functions for array operations
-class ArrayHelper {
+template <class Instrumentation = NoInstrumentation>
+class BasicArrayHelper {
 public:
   static void swap(int arr[], int pos1, int pos2) {
+    Instrumentation::count(Operation::Swap);
     int temp = arr[pos1];
     arr[pos1] = arr[pos2];
     arr[pos2] = temp;
@@ -85,7 +882,9 @@ public:
     cout << endl;
   }
   //--------------------------------------------------------->
-  // Generate a random array with given size and range
+  // Generate a random array with given size and range.
+  // Values come from DataGenerator, seeded from rand() so srand() still picks the sequence.
+  // The caller owns the result and frees it with delete[]
   static int* generateRandomArray(int size, int minimum_num, int maximum_num) {
       // Check for invalid input parameters
       if (size <= 0 || minimum_num > maximum_num) {
@@ -96,22 +895,59 @@ public:
       // Allocate memory for the array
       int* arr = new int[size];
 
-      // Generate random numbers within the specified range and store them in the array
-      for (int i = 0; i < size; i++) {
-          // Generate a random integer between 0 and (maximum_num - minimum_num) inclusive
-          int random_num = rand() % (maximum_num - minimum_num + 1);
-          // Add the minimum number to the random number to get a number within the desired range
-          arr[i] = minimum_num + random_num;
-      }
+      GeneratorOptions options;
+      options.minimum_num = minimum_num;
+      options.maximum_num = maximum_num;
+      options.seed = static_cast<uint64_t>(rand());
+      DataGenerator::fill(arr, size, options);
 
       return arr; // Return the pointer to the generated array
   }
+
+  // Same, with the storage taken from resource and given back by the vector.
+  // Returns an empty vector on invalid parameters.
+  static pmr::vector<int> generateRandomArray(int size, int minimum_num, int maximum_num,
+                                              pmr::memory_resource* resource) {
+      pmr::vector<int> arr(resource);
+      if (size <= 0 || minimum_num > maximum_num) {
+          cerr << "Invalid parameters for random array generation!" << endl;
+          return arr;
+      }
+      arr.resize(size_t(size));
+
+      GeneratorOptions options;
+      options.minimum_num = minimum_num;
+      options.maximum_num = maximum_num;
+      options.seed = static_cast<uint64_t>(rand());
+      DataGenerator::fill(arr.data(), size, options);
+
+      return arr;
+  }
+  //--------------------------------------------------------->
+
+  // Generic versions for any element type
+  template <class T>
+  static void swap(span<T> arr, size_t pos1, size_t pos2) {
+    Instrumentation::count(Operation::Swap);
+    using std::swap;
+    swap(arr[pos1], arr[pos2]);
+  }
+
+  template <class T, class Proj = identity>
+  static void printArray(span<T> arr, Proj proj = {}) {
+    for (const T& element : arr) {
+      cout << invoke(proj, element) << " ";
+    }
+    cout << endl;
+  }
   //--------------------------------------------------------->
 };
 
+using ArrayHelper = BasicArrayHelper<>;
+
 const int maxQueue = 100; // Define the maximum size of the queue
 
-template <class queueElementType>
+template <class queueElementType, class Latency = NoLatency>
 class Queue {
 private:
     queueElementType queueArray[maxQueue]; // Array to store queue elements
@@ -139,6 +975,7 @@ public:
 
     // Add an element to the rear of the queue
     void enqueue(queueElementType e) {
+        typename Latency::Scope timed(TimedOperation::Enqueue);
         assert(!isFull()); // Ensure the queue is not full
         queueArray[rear] = e; // Insert element at the rear
         rear = nextPos(rear); // Move rear to the next position
@@ -146,6 +983,7 @@ public:
 
     // Remove and return the element from the front of the queue
     queueElementType dequeue() {
+        typename Latency::Scope timed(TimedOperation::Dequeue);
         assert(!isEmpty()); // Ensure the queue is not empty
         queueElementType result = queueArray[front]; // Get the front element
         front = nextPos(front); // Move front to the next position
@@ -177,7 +1015,8 @@ public:
 
 
 
-class HashTable {
+template <class Instrumentation = NoInstrumentation, class Latency = NoLatency>
+class BasicHashTable {
 
 public:
 
@@ -188,6 +1027,18 @@ public:
         string hireDate;    // Person's hire date in MM-DD-YYYY format
     };
 
+    // The same record with its strings in a memory_resource. The table stores
+    // these, so its copies of the strings live in the table's resource; callers
+    // working in an arena can insert and look up PersonRecords directly.
+    struct PersonRecord {
+        pmr::string lastName;
+        pmr::string firstName;
+        pmr::string hireDate;
+
+        explicit PersonRecord(pmr::memory_resource* resource = pmr::get_default_resource())
+            : lastName(resource), firstName(resource), hireDate(resource) {}
+    };
+
     // Enum to represent the status of each slot in the hash table
     enum SlotType { Empty, Deleted, InUse };
 
@@ -195,12 +1046,13 @@ public:
     struct Slot {
         SlotType status;    // Status of the slot (Empty, Deleted, InUse)
         int key;            // Key stored in the slot (Person ID)
-        PersonData data;  // Data associated with the key
+        PersonRecord data;  // Data associated with the key
     };
 
     static const int maxTable = 11; // Size of the hash table (prime number to reduce collisions)
     Slot hashTableArray[maxTable];  // Array to represent the hash table
     int entries; // Number of valid entries (slots marked as InUse) in the hash table
+    int deleted; // Number of tombstones (slots marked as Deleted); at least one slot always stays Empty
 
     // Hash function to calculate the index for a given key
     int hash(int key) {
@@ -209,6 +1061,8 @@ public:
 
     // Helper function to determine the next position in the hash table (linear probing)
     int probe(int pos) {
+        Instrumentation::count(Operation::Probe);
+        Latency::countProbe();
         if (pos == maxTable - 1) // If at the end of the table, wrap around to the beginning
             return 0;
         else
@@ -217,7 +1071,9 @@ public:
 
     // Private method to search for a key in the hash table
     bool search(int searchKey, int& pos) {
-        while (hashTableArray[pos].status != Empty) { // Continue searching until an empty slot is found
+        // Continue searching until an empty slot is found, or every slot has been checked
+        for (int checked = 0; checked < maxTable && hashTableArray[pos].status != Empty; checked++) {
+            Instrumentation::count(Operation::Comparison);
             if (hashTableArray[pos].status == InUse && hashTableArray[pos].key == searchKey) {
                 return true; // Key found
             } else {
@@ -227,12 +1083,10 @@ public:
         return false; // Key not found
     }
 
-    // Constructor to initialize the hash table
-    HashTable() : entries(0) {
-        for (int i = 0; i < maxTable; i++) {
-            hashTableArray[i].status = Empty; // Mark all slots as Empty
-        }
-    }
+    // Constructor to initialize the hash table; stored strings are allocated
+    // from resource, because assigning to a pmr string keeps the target's resource
+    explicit BasicHashTable(pmr::memory_resource* resource = pmr::get_default_resource())
+        : BasicHashTable(resource, make_index_sequence<maxTable>()) {}
 
     // Method to check if the hash table is empty
     bool isEmpty() const {
@@ -256,42 +1110,32 @@ public:
 
     // Method to insert a new key and data into the hash table
     void insert(int insertKey, const PersonData& insertData) {
-        assert(entries < maxTable - 1); // Ensure the table is not full
-        int pos = hash(insertKey); // Calculate the home address for the key
+        insertRecord(insertKey, insertData);
+    }
 
-        if (!search(insertKey, pos)) { // If the key does not exist in the table
-            pos = hash(insertKey); // Recalculate the home address
-            while (hashTableArray[pos].status == InUse) { // Find the next available slot
-                pos = probe(pos);
-            }
-            // Insert the key and data into the available slot
-            hashTableArray[pos].status = InUse;
-            hashTableArray[pos].key = insertKey;
-            hashTableArray[pos].data = insertData;
-            entries++; // Increment the number of entries
-        } else {
-            // If the key exists, update the data
-            hashTableArray[pos].data = insertData;
-        }
+    // Same, for a record whose strings already live in a memory_resource
+    void insert(int insertKey, const PersonRecord& insertData) {
+        insertRecord(insertKey, insertData);
     }
 
     // Method to lookup data associated with a key in the hash table
     bool lookup(int lookupKey, PersonData& lookupData) {
-        int pos = hash(lookupKey); // Calculate the home address for the key
-        if (search(lookupKey, pos)) { // If the key is found
-            lookupData = hashTableArray[pos].data; // Retrieve the data
-            return true;
-        } else {
-            return false; // Key not found
-        }
+        return lookupRecord(lookupKey, lookupData);
+    }
+
+    // Same, copying into a record whose strings use its own memory_resource
+    bool lookup(int lookupKey, PersonRecord& lookupData) {
+        return lookupRecord(lookupKey, lookupData);
     }
 
     // Method to delete a key and its associated data from the hash table
     void deleteKey(int deleteKey) {
+        typename Latency::Scope timed(TimedOperation::HashDelete);
         int pos = hash(deleteKey); // Calculate the home address for the key
         if (search(deleteKey, pos)) { // If the key is found
             hashTableArray[pos].status = Deleted; // Mark the slot as Deleted
             entries--; // Decrement the number of entries
+            deleted++;
         }
     }
 
@@ -313,12 +1157,95 @@ public:
         }
         cout << endl << "Table size: " << getSize() << ", Number of current entries: " << getLength() << endl;
     }
+
+private:
+
+    // Give every slot a PersonRecord bound to resource as it is constructed
+    template <size_t... I>
+    BasicHashTable(pmr::memory_resource* resource, index_sequence<I...>)
+        : hashTableArray{ ((void)I, Slot{ Empty, 0, PersonRecord(resource) })... }, entries(0), deleted(0) {}
+
+    // Copy the three strings field by field; assign() keeps each target's allocator
+    template <class From, class To>
+    static void copyPerson(const From& from, To& to) {
+        to.lastName.assign(from.lastName);
+        to.firstName.assign(from.firstName);
+        to.hireDate.assign(from.hireDate);
+    }
+
+    // Turn every tombstone back into an empty slot and move each entry to the
+    // first free slot from its home address. Walking once around the table from
+    // a slot that was already empty, no entry's probe path crosses that slot,
+    // so a slot emptied by a later move is never on an earlier entry's path.
+    void purgeDeleted() {
+        int start = 0;
+        while (hashTableArray[start].status != Empty) start++;
+        for (Slot& slot : hashTableArray) {
+            if (slot.status == Deleted) slot.status = Empty;
+        }
+        deleted = 0;
+        for (int step = 1; step < maxTable; step++) {
+            int pos = (start + step) % maxTable;
+            if (hashTableArray[pos].status != InUse) continue;
+            int target = hash(hashTableArray[pos].key);
+            while (target != pos && hashTableArray[target].status == InUse) {
+                target = (target + 1) % maxTable;
+            }
+            if (target != pos) {
+                hashTableArray[target].status = InUse;
+                hashTableArray[target].key = hashTableArray[pos].key;
+                swap(hashTableArray[target].data, hashTableArray[pos].data);
+                hashTableArray[pos].status = Empty;
+            }
+        }
+    }
+
+    template <class Person>
+    void insertRecord(int insertKey, const Person& insertData) {
+        typename Latency::Scope timed(TimedOperation::HashInsert);
+        assert(entries < maxTable - 1); // Ensure the table is not full
+        if (deleted > 0 && entries + deleted >= maxTable - 1) {
+            purgeDeleted(); // Tombstones have used up all but the last empty slot
+        }
+        int pos = hash(insertKey); // Calculate the home address for the key
+
+        if (!search(insertKey, pos)) { // If the key does not exist in the table
+            pos = hash(insertKey); // Recalculate the home address
+            while (hashTableArray[pos].status == InUse) { // Find the next available slot
+                pos = probe(pos);
+            }
+            // Insert the key and data into the available slot
+            if (hashTableArray[pos].status == Deleted) deleted--; // Reusing a tombstone
+            hashTableArray[pos].status = InUse;
+            hashTableArray[pos].key = insertKey;
+            copyPerson(insertData, hashTableArray[pos].data);
+            entries++; // Increment the number of entries
+        } else {
+            // If the key exists, update the data
+            copyPerson(insertData, hashTableArray[pos].data);
+        }
+    }
+
+    template <class Person>
+    bool lookupRecord(int lookupKey, Person& lookupData) {
+        typename Latency::Scope timed(TimedOperation::HashLookup);
+        int pos = hash(lookupKey); // Calculate the home address for the key
+        if (search(lookupKey, pos)) { // If the key is found
+            copyPerson(hashTableArray[pos].data, lookupData); // Retrieve the data
+            return true;
+        } else {
+            return false; // Key not found
+        }
+    }
 };
 
+using HashTable = BasicHashTable<>;
 
 
 
-class LinkedList {
+
+template <class Instrumentation = NoInstrumentation>
+class BasicLinkedList {
     private:
       // Node structure for the linked list
       struct Node {
@@ -331,24 +1258,26 @@ class LinkedList {
 
       Node* head; // Pointer to the head of the linked list
       Node* tail; // Pointer to the tail of the linked list
+      pmr::polymorphic_allocator<Node> allocator; // Source of every node of this list
 
     public:
-      // Default constructor to initialize an empty linked list
-      LinkedList() : head(nullptr) {}
+      // Constructor to initialize an empty linked list whose nodes come from resource
+      explicit BasicLinkedList(pmr::memory_resource* resource = pmr::get_default_resource())
+          : head(nullptr), allocator(resource) {}
 
       // Destructor to deallocate memory and prevent memory leaks
-      ~LinkedList() {
+      ~BasicLinkedList() {
         while (head != nullptr) { // Iterate through the list and delete each node
           Node* temp = head; // Store the current head node
           head = head->next; // Move the head pointer to the next node
-          delete temp; // Delete the current head node
+          freeNode(temp); // Delete the current head node
         }
       }
 
         // Insert a new node at the beginning of the linked list
         void insertAtStart(int value) {
             // Create a new node with the given value
-            Node* newNode = new Node(value);
+            Node* newNode = allocateNode(value);
             // Set the next pointer of the new node to the current head
             newNode->next = head;
             // Update the head pointer to point to the new node
@@ -359,7 +1288,7 @@ class LinkedList {
         // Insert a new node at the end of the linked list
         void insertAtEnd(int value) {
             // Create a new node with the given value
-            Node* newNode = new Node(value);
+            Node* newNode = allocateNode(value);
 
             // If the list is empty, set the new node as the head
             if (head == nullptr) {
@@ -391,7 +1320,7 @@ class LinkedList {
         }
 
         // Create a new node to be inserted
-        Node* newNode = new Node(value);
+        Node* newNode = allocateNode(value);
 
         // Initialize a pointer to traverse the list
         Node* current = head;
@@ -406,7 +1335,7 @@ class LinkedList {
         // Check if the specified position is within the list's bounds
         if (current == nullptr) {
             cout << "Position out of bounds. The list has only " << currentPos << " elements." << endl;
-            delete newNode; // Clean up the unused node
+            freeNode(newNode); // Clean up the unused node
             return;
         }
 
@@ -431,7 +1360,7 @@ class LinkedList {
       head = head->next;
 
       // Deallocate the memory of the deleted node
-      delete toDelete;
+      freeNode(toDelete);
   }
 //--------------------------------------------------------------------------------------->
 
@@ -445,7 +1374,7 @@ class LinkedList {
 
       // Case 2: Only one node in the list
       if (head->next == nullptr) {
-          delete head;
+          freeNode(head);
           head = nullptr;
           return;
       }
@@ -458,7 +1387,7 @@ class LinkedList {
       }
 
       // Now current points to second-to-last node
-      delete current->next;       // Delete the last node
+      freeNode(current->next);       // Delete the last node
       current->next = nullptr;    // Set the new last node's next to nullptr
   }
 //--------------------------------------------------------------------------------------->
@@ -475,7 +1404,7 @@ class LinkedList {
       if (head->data == key) {
           Node* toDelete = head;
           head = head->next;
-          delete toDelete;
+          freeNode(toDelete);
           return;
       }
 
@@ -499,7 +1428,7 @@ class LinkedList {
       // Remove the node containing the key
       Node* toDelete = current->next;           // Store node to delete
       current->next = current->next->next;      // Skip over the node
-      delete toDelete;                          // Free the memory
+      freeNode(toDelete);                          // Free the memory
   }
 //--------------------------------------------------------------------------------------->
 
@@ -530,7 +1459,7 @@ class LinkedList {
         while (head != nullptr) {
             Node* temp = head;
             head = head->next;
-            delete temp;
+            freeNode(temp);
         }
         tail = nullptr;
     }
@@ -568,7 +1497,7 @@ class LinkedList {
 //--------------------------------------------------------------------------------------->
 
     // Compare two linked lists
-    bool compare(const LinkedList& other) const {
+    bool compare(const BasicLinkedList& other) const {
         Node* current1 = head;
         Node* current2 = other.head;
         while (current1 != nullptr && current2 != nullptr) {
@@ -589,217 +1518,2863 @@ class LinkedList {
             if (current->data == current->next->data) {
                 Node* temp = current->next;
                 current->next = temp->next;
-                delete temp;
+                freeNode(temp);
             } else {
                 current = current->next;
             }
         }
     }
+//--------------------------------------------------------------------------------------->
+
+    // Sort the list in place (stable bottom-up merge sort).
+    // Nodes are relinked rather than copied, so no memory is allocated.
+    void sort() {
+        int length = 0;
+        for (Node* current = head; current != nullptr; current = current->next) {
+            length++;
+        }
+
+        Node dummy(0); // Anchor for the sorted sublists of each pass
+        dummy.next = head;
+        for (int width = 1; width < length; width *= 2) {
+            Node* current = dummy.next;
+            Node* merged = &dummy; // Last node of the output built so far
+            while (current != nullptr) {
+                Node* left = current;
+                Node* right = split(left, width);
+                current = split(right, width);
+                merged = mergeNodes(left, right, merged);
+            }
+        }
+        head = dummy.next;
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Merge another sorted list into this sorted list in linear time.
+    // The nodes of other are spliced in, leaving other empty; if the lists
+    // use different memory resources its values are copied into ours instead.
+    void mergeSorted(BasicLinkedList& other) {
+        if (&other == this) return;
+        Node* incoming = other.head;
+        if (allocator != other.allocator) {
+            Node copied(0);
+            Node* last = &copied;
+            while (other.head != nullptr) {
+                Node* moved = other.head;
+                other.head = moved->next;
+                last->next = allocateNode(moved->data);
+                last = last->next;
+                other.freeNode(moved);
+            }
+            incoming = copied.next;
+        }
+        Node dummy(0);
+        mergeNodes(head, incoming, &dummy);
+        head = dummy.next;
+        other.head = nullptr;
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Sort the list and keep one node per distinct value
+    void sortUnique() {
+        sort();
+        removeDuplicates();
+    }
+//--------------------------------------------------------------------------------------->
+
+private:
+    // Allocate a node, reporting the allocation to the instrumentation policy
+    Node* allocateNode(int value) {
+        Instrumentation::count(Operation::Allocation);
+        return allocator.template new_object<Node>(value);
+    }
+
+    void freeNode(Node* node) {
+        allocator.delete_object(node);
+    }
+
+    // Cut the list after n nodes and return the head of the remainder
+    static Node* split(Node* start, int n) {
+        for (int i = 1; start != nullptr && i < n; i++) {
+            start = start->next;
+        }
+        if (start == nullptr) return nullptr;
+        Node* rest = start->next;
+        start->next = nullptr;
+        return rest;
+    }
+
+    // Append the merge of two sorted chains after tail and return the new tail
+    static Node* mergeNodes(Node* left, Node* right, Node* tail) {
+        while (left != nullptr && right != nullptr) {
+            Instrumentation::count(Operation::Comparison);
+            if (left->data <= right->data) { // <= keeps equal keys in order
+                tail->next = left;
+                left = left->next;
+            } else {
+                tail->next = right;
+                right = right->next;
+            }
+            tail = tail->next;
+        }
+        tail->next = (left != nullptr) ? left : right;
+        while (tail->next != nullptr) {
+            tail = tail->next;
+        }
+        return tail;
+    }
+//--------------------------------------------------------------------------------------->
+};
+
+using LinkedList = BasicLinkedList<>;
+
+// Indexable skip list: an ordered list of ints where every forward link also
+// stores its width (how many bottom-level nodes it jumps over). Adding up the
+// widths along a search path gives a node's position, so keyed and positional
+// operations are both O(log n) expected instead of a linear scan.
+template <class Instrumentation = NoInstrumentation>
+class BasicIndexedSkipList {
+    private:
+      static const int maxLevel = 32; // Enough levels for 4^32 elements
+
+      struct Node;
+
+      // One forward link per level
+      struct Link {
+        Node* next; // Next node on this level (nullptr = end of list)
+        int width;  // Number of bottom-level steps this link covers
+      };
+
+      // A node and its links share one allocation, the links right after the node
+      struct Node {
+        int data;    // Data stored in the node
+        int level;   // Number of levels this node takes part in
+        Link* links; // Forward links, one per level
+
+        Node(int value, int levels, Link* nodeLinks) : data(value), level(levels), links(nodeLinks) {}
+      };
+
+      pmr::memory_resource* resource; // Source of every node, header included
+      Node* head;    // Header node, it owns a link on every level
+      int levels;    // Number of levels currently in use
+      int length;    // Number of elements in the list
+      uint64_t seed; // xorshift state used to pick node levels
+
+      // Concurrent mode: readers share the lock, writers take it exclusively,
+      // so writes are serialised against all reads
+      bool concurrent;
+      mutable shared_mutex rwLock;
+
+      shared_lock<shared_mutex> readLock() const {
+          return concurrent ? shared_lock<shared_mutex>(rwLock) : shared_lock<shared_mutex>(rwLock, defer_lock);
+      }
+
+      unique_lock<shared_mutex> writeLock() {
+          return concurrent ? unique_lock<shared_mutex>(rwLock) : unique_lock<shared_mutex>(rwLock, defer_lock);
+      }
+
+      static size_t nodeBytes(int level) {
+          return sizeof(Node) + size_t(level) * sizeof(Link);
+      }
+
+      Node* createNode(int value, int level) {
+          Instrumentation::count(Operation::Allocation);
+          void* memory = resource->allocate(nodeBytes(level), alignof(Node));
+          Node* node = static_cast<Node*>(memory);
+          return new (memory) Node(value, level, reinterpret_cast<Link*>(node + 1));
+      }
+
+      void destroyNode(Node* node) {
+          resource->deallocate(node, nodeBytes(node->level), alignof(Node));
+      }
+
+      // Pick a level with P(level > k) = 1/4^k
+      int randomLevel() {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          int level = 1 + countr_zero(seed | (uint64_t(1) << 62)) / 2;
+          return level < maxLevel ? level : maxLevel;
+      }
+
+      // Splice a new node in after update[i] on every level.
+      // rank[i] is the position of update[i] (the header is position 0).
+      void linkNode(int value, Node* update[], int rank[]) {
+          int level = randomLevel();
+          if (level > levels) {
+              for (int i = levels; i < level; i++) {
+                  update[i] = head;
+                  rank[i] = 0;
+                  head->links[i].next = nullptr;
+                  head->links[i].width = length + 1; // Distance to the end of the list
+              }
+              levels = level;
+          }
+
+          Node* newNode = createNode(value, level);
+          int newPos = rank[0] + 1;
+          for (int i = 0; i < level; i++) {
+              Link& prev = update[i]->links[i];
+              newNode->links[i].next = prev.next;
+              newNode->links[i].width = rank[i] + prev.width + 1 - newPos;
+              prev.next = newNode;
+              prev.width = newPos - rank[i];
+          }
+          // Links that jump over the new node grow by one
+          for (int i = level; i < levels; i++) {
+              update[i]->links[i].width++;
+          }
+          length++;
+      }
+
+      // Unlink update[0]'s successor from every level and free it
+      void unlinkNode(Node* update[]) {
+          Node* toDelete = update[0]->links[0].next;
+          for (int i = 0; i < levels; i++) {
+              Link& prev = update[i]->links[i];
+              if (prev.next == toDelete) {
+                  prev.width += toDelete->links[i].width - 1;
+                  prev.next = toDelete->links[i].next;
+              } else {
+                  prev.width--;
+              }
+          }
+          destroyNode(toDelete);
+          // Drop levels that became empty
+          while (levels > 1 && head->links[levels - 1].next == nullptr) {
+              levels--;
+          }
+          length--;
+      }
+
+      // Fill update[] with the last node on each level whose key is < key
+      // (or <= key when afterEqual is set) and return its position.
+      int findPredecessors(int key, bool afterEqual, Node* update[], int rank[]) const {
+          Node* current = head;
+          int pos = 0;
+          for (int i = levels - 1; i >= 0; i--) {
+              while (current->links[i].next != nullptr) {
+                  int nextKey = current->links[i].next->data;
+                  Instrumentation::count(Operation::Comparison);
+                  if (!(nextKey < key || (afterEqual && nextKey == key))) break;
+                  pos += current->links[i].width;
+                  current = current->links[i].next;
+              }
+              update[i] = current;
+              rank[i] = pos;
+          }
+          return pos;
+      }
+
+      // Fill update[] with the predecessors of the 1-based position target
+      void findPosition(int target, Node* update[], int rank[]) const {
+          Node* current = head;
+          int pos = 0;
+          for (int i = levels - 1; i >= 0; i--) {
+              while (current->links[i].next != nullptr && pos + current->links[i].width < target) {
+                  pos += current->links[i].width;
+                  current = current->links[i].next;
+              }
+              update[i] = current;
+              rank[i] = pos;
+          }
+      }
+
+      void clear() {
+          Node* current = head->links[0].next;
+          while (current != nullptr) {
+              Node* temp = current;
+              current = current->links[0].next;
+              destroyNode(temp);
+          }
+          for (int i = 0; i < maxLevel; i++) {
+              head->links[i].next = nullptr;
+              head->links[i].width = 1;
+          }
+          levels = 1;
+          length = 0;
+      }
+
+    public:
+      // Pass concurrent = true to share the list between threads. This is a plain
+      // reader/writer lock: readers run alongside each other, but an insert or
+      // remove blocks every reader until it is done.
+      // Nodes, header included, come from nodeResource.
+      BasicIndexedSkipList(bool concurrentMode = false, uint64_t levelSeed = 0x9E3779B97F4A7C15ull,
+                      pmr::memory_resource* nodeResource = pmr::get_default_resource())
+          : resource(nodeResource), head(createNode(0, maxLevel)), levels(1), length(0),
+            seed(levelSeed ? levelSeed : 1), concurrent(concurrentMode) {
+          for (int i = 0; i < maxLevel; i++) {
+              head->links[i].next = nullptr;
+              head->links[i].width = 1;
+          }
+      }
+
+      BasicIndexedSkipList(const BasicIndexedSkipList&) = delete;
+      BasicIndexedSkipList& operator=(const BasicIndexedSkipList&) = delete;
+
+      // Destructor to deallocate memory and prevent memory leaks
+      ~BasicIndexedSkipList() {
+          clear();
+          destroyNode(head);
+      }
+//--------------------------------------------------------------------------------------->
+
+    // Insert a key keeping the list ordered (after any equal keys)
+    void insert(int key) {
+        auto lock = writeLock();
+        Node* update[maxLevel] = {};
+        int rank[maxLevel];
+        findPredecessors(key, true, update, rank);
+        linkNode(key, update, rank);
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Insert at a specific position (0-based index); the value must keep the list ordered
+    void insertAtPosition(int value, int position) {
+        auto lock = writeLock();
+        if (position < 0 || position > length) {
+            cout << "Position out of bounds. The list has only " << length << " elements." << endl;
+            return;
+        }
+
+        Node* update[maxLevel] = {};
+        int rank[maxLevel];
+        findPosition(position + 1, update, rank);
+
+        Node* next = update[0]->links[0].next;
+        if ((update[0] != head && update[0]->data > value) || (next != nullptr && next->data < value)) {
+            cout << "Inserting " << value << " at position " << position << " would break the list order." << endl;
+            return;
+        }
+        linkNode(value, update, rank);
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Remove the first node with a specific key
+    void removeKey(int key) {
+        auto lock = writeLock();
+        Node* update[maxLevel] = {};
+        int rank[maxLevel];
+        findPredecessors(key, false, update, rank);
+
+        Node* target = update[0]->links[0].next;
+        if (target == nullptr || target->data != key) {
+            cout << "Key " << key << " not found in the list." << endl;
+            return;
+        }
+        unlinkNode(update);
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Remove the node at a specific position (0-based index)
+    void removeAtPosition(int position) {
+        auto lock = writeLock();
+        if (position < 0 || position >= length) {
+            cout << "Position out of bounds. The list has only " << length << " elements." << endl;
+            return;
+        }
+
+        Node* update[maxLevel] = {};
+        int rank[maxLevel];
+        findPosition(position + 1, update, rank);
+        unlinkNode(update);
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Return the position of the first occurrence of key, or -1 if it is absent
+    int find(int key) const {
+        auto lock = readLock();
+        Node* update[maxLevel] = {};
+        int rank[maxLevel];
+        int pos = findPredecessors(key, false, update, rank);
+
+        Node* target = update[0]->links[0].next;
+        return (target != nullptr && target->data == key) ? pos : -1;
+    }
+
+    // Return the element at a specific position (0-based index)
+    int at(int position) const {
+        auto lock = readLock();
+        assert(position >= 0 && position < length);
+        Node* current = head;
+        int pos = 0;
+        for (int i = levels - 1; i >= 0; i--) {
+            while (current->links[i].next != nullptr && pos + current->links[i].width <= position + 1) {
+                pos += current->links[i].width;
+                current = current->links[i].next;
+            }
+        }
+        return current->data;
+    }
+//--------------------------------------------------------------------------------------->
+
+    // Print the list
+    void print() const {
+        auto lock = readLock();
+        for (Node* current = head->links[0].next; current != nullptr; current = current->links[0].next) {
+            cout << current->data << " ";
+        }
+        cout << endl;
+    }
+
+    // Check if the list is empty
+    bool isEmpty() const {
+        auto lock = readLock();
+        return length == 0;
+    }
+
+    // Get the number of elements in the list
+    int getLength() const {
+        auto lock = readLock();
+        return length;
+    }
+
+    // Make the list empty
+    void makeEmpty() {
+        auto lock = writeLock();
+        clear();
+    }
+//--------------------------------------------------------------------------------------->
+};
+
+using IndexedSkipList = BasicIndexedSkipList<>;
+
+// Search algorithms
+template <class Instrumentation = NoInstrumentation>
+class BasicSearchAlgorithms {
+public:
+  static int binarySearch(int arr[], int size, int target) {
+      int left = 0,right = size - 1;  // Initialize right to last index
+
+      while (left <= right) {  // KEY DIFFERENCE 1: Uses <= to ensure all elements are checked
+          // KEY DIFFERENCE 2: Simple mid calculation is fine since overflow is rare in practice
+          int mid = (left + right) / 2;
+          Instrumentation::count(Operation::Probe);
+          Instrumentation::count(Operation::Comparison);
+          if (arr[mid] == target) {
+              return mid;
+          }else if (arr[mid] > target) {
+              right = mid - 1;  // KEY DIFFERENCE 3: Properly reduces right boundary
+          }else {
+              left = mid + 1;
+          }
+      }
+      return -1;  // KEY DIFFERENCE 4: Always returns -1 if target not found
+  }
+  //--------------------------------------------------------->
+
+  // Defective Binary Search Implementation (with fixes commented)
+  static int defectiveBinarySearch(int arr[], int size, int target) {
+      int left = 0, right = size - 1;
+
+      // DEFECT 1: Uses < instead of <=, which can miss checking the last element
+      while (left < right ) {  // Should be: while (left <= right)
+          // More robust mid calculation to prevent integer overflow
+          int mid = left + (right - left) / 2;
+          if (arr[mid] == target) {
+              return mid;
+          }else if (arr[mid] < target){
+                left = mid;
+          }else {
+              right = mid;                            // DEFECT 2: Doesn't decrease right boundary properly
+          }                                          // Should be: right = mid - 1
+      }
+
+    cout << "Not Found" << endl;
+  }
+
+  //--------------------------------------------------------->
+
+    // Linear Search: Iterative
+  static int linearSearch(int arr[], int size, int target) {
+      for (int i = 0; i < size; i++) {
+          Instrumentation::count(Operation::Comparison);
+          if (arr[i] == target) {
+              return i;  // Return the index of the target
+          }
+      }
+      return -1;  // Return -1 if target not found
+  }
+  //--------------------------------------------------------->
+
+  // Linear Search: Recursive
+  static int recursiveLinearSearch(int arr[], int size, int target, int index = 0) {
+      if (index >= size) {
+          return -1;  // Base case: target not found
+      }
+      Instrumentation::count(Operation::Comparison);
+      if (arr[index] == target) {
+          return index;  // Base case: target found
+      }
+      return recursiveLinearSearch(arr, size, target, index + 1);  // Recursive case
+  }
+  //--------------------------------------------------------->
+
+  // Generic binary search: arr must be sorted by comp on proj(element).
+  // Returns the index of an element whose key equals target, or -1.
+  template <class T, class Key, class Compare = ranges::less, class Proj = identity>
+  static ptrdiff_t binarySearch(span<T> arr, const Key& target, Compare comp = {}, Proj proj = {}) {
+      ptrdiff_t left = 0, right = ptrdiff_t(arr.size()) - 1;
+      while (left <= right) {
+          ptrdiff_t mid = left + (right - left) / 2;
+          const auto& key = invoke(proj, arr[mid]);
+          Instrumentation::count(Operation::Probe);
+          Instrumentation::count(Operation::Comparison);
+          if (invoke(comp, key, target)) {
+              left = mid + 1;
+          } else if (invoke(comp, target, key)) {
+              right = mid - 1;
+          } else {
+              return mid;
+          }
+      }
+      return -1;
+  }
+
+  // Generic linear search on proj(element) == target
+  template <class T, class Key, class Proj = identity>
+  static ptrdiff_t linearSearch(span<T> arr, const Key& target, Proj proj = {}) {
+      for (size_t i = 0; i < arr.size(); i++) {
+          Instrumentation::count(Operation::Comparison);
+          if (invoke(proj, arr[i]) == target) {
+              return ptrdiff_t(i);
+          }
+      }
+      return -1;
+  }
+};
+
+using SearchAlgorithms = BasicSearchAlgorithms<>;
+
+// Read-only sorted int sequence stored in compressed 128-value blocks.
+// Values are mapped to uint32 (sign bit flipped, which keeps the order) and
+// each block stores them as deltas against the value four places earlier,
+// split over four interleaved lanes so the prefix sum runs four at a time in
+// SIMD registers. Each block packs its deltas at the smallest bit width b
+// that fits (frame of reference), 4 * b words in all. A skip index of block
+// minimums sends find/lowerBound to a single block, so no lookup or
+// iteration step ever decodes more than one block.
+class CompressedSortedArray {
+public:
+    static constexpr int blockSize = 128;
+
+    // Iterates in order, decoding one block into a local buffer at a time.
+    // Values live in that buffer, so * returns them by value: to the classic
+    // iterator categories this is an input iterator, to ranges a forward one.
+    class Iterator {
+    public:
+        using iterator_concept = forward_iterator_tag;
+        using iterator_category = input_iterator_tag;
+        using value_type = int;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = int;
+
+        Iterator() : owner(nullptr), index(0), block(-1) {}
+        Iterator(const CompressedSortedArray* owner, int index) : owner(owner), index(index), block(-1) {
+            load();
+        }
+
+        int operator*() const {
+            return values[index % blockSize];
+        }
+
+        Iterator& operator++() {
+            index++;
+            if (index % blockSize == 0) load();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index == other.index;
+        }
+
+    private:
+        const CompressedSortedArray* owner;
+        int index;
+        int block; // Block held in values, -1 if none
+        array<int, blockSize> values;
+
+        void load() {
+            if (owner != nullptr && index < owner->size() && index / blockSize != block) {
+                block = index / blockSize;
+                owner->decodeBlock(block, values.data());
+            }
+        }
+    };
+
+    // The packed data and the skip index are allocated from resource
+    explicit CompressedSortedArray(pmr::memory_resource* resource = pmr::get_default_resource())
+        : length(0), words(resource), blockMin(resource), blockBits(resource), blockOffset(resource) {}
+
+    CompressedSortedArray(const int arr[], int size, pmr::memory_resource* resource = pmr::get_default_resource())
+        : CompressedSortedArray(resource) {
+        build(arr, size);
+    }
+
+    // Replace the contents with arr, which must be sorted ascending;
+    // returns false and leaves the array empty otherwise
+    bool build(const int arr[], int size) {
+        clear();
+        if (size < 0 || (size > 0 && arr == nullptr)) {
+            cerr << "Invalid parameters for compressed array!" << endl;
+            return false;
+        }
+        if (!is_sorted(arr, arr + size)) {
+            cerr << "Compressed array input must be sorted!" << endl;
+            return false;
+        }
+        length = size;
+        int blocks = (size + blockSize - 1) / blockSize;
+        blockMin.resize(blocks);
+        blockBits.resize(blocks);
+        blockOffset.resize(blocks);
+        for (int b = 0; b < blocks; b++) {
+            encodeBlock(b, arr + b * blockSize, std::min(blockSize, size - b * blockSize));
+        }
+        words.shrink_to_fit();
+        return true;
+    }
+
+    void clear() {
+        length = 0;
+        words.clear();
+        blockMin.clear();
+        blockBits.clear();
+        blockOffset.clear();
+    }
+
+    int size() const {
+        return length;
+    }
+
+    bool isEmpty() const {
+        return length == 0;
+    }
+
+    // Bytes held by the packed data and the skip index
+    size_t memoryBytes() const {
+        return words.size() * sizeof(uint32_t) + blockMin.size() * sizeof(uint32_t) +
+               blockBits.size() * sizeof(uint8_t) + blockOffset.size() * sizeof(uint32_t);
+    }
+
+    // Index of the first value >= target, or size() if there is none
+    int lowerBound(int target) const {
+        uint32_t key = toKey(target);
+        // Every block before the first one whose minimum is >= target holds
+        // only smaller values, except possibly the block just before it
+        int next = int(std::lower_bound(blockMin.begin(), blockMin.end(), key) - blockMin.begin());
+        if (next == 0) return 0;
+        int block = next - 1;
+        array<int, blockSize> values;
+        int count = decodeBlock(block, values.data());
+        int inBlock = int(std::lower_bound(values.begin(), values.begin() + count, target) - values.begin());
+        return inBlock < count ? block * blockSize + inBlock : std::min(next * blockSize, length);
+    }
+
+    // Index of an element equal to target, or -1 if there is none (like binarySearch).
+    // Only the last block starting at or below target can hold it.
+    int find(int target) const {
+        int next = int(std::upper_bound(blockMin.begin(), blockMin.end(), toKey(target)) - blockMin.begin());
+        if (next == 0) return -1;
+        int block = next - 1;
+        array<int, blockSize> values;
+        int count = decodeBlock(block, values.data());
+        int inBlock = int(std::lower_bound(values.begin(), values.begin() + count, target) - values.begin());
+        return inBlock < count && values[inBlock] == target ? block * blockSize + inBlock : -1;
+    }
+
+    bool contains(int target) const {
+        return find(target) != -1;
+    }
+
+    int at(int index) const {
+        assert(index >= 0 && index < length);
+        array<int, blockSize> values;
+        decodeBlock(index / blockSize, values.data());
+        return values[index % blockSize];
+    }
+
+    Iterator begin() const {
+        return Iterator(this, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(nullptr, length);
+    }
+
+    // Decode block b into out (room for blockSize ints); returns its element count
+    int decodeBlock(int b, int out[]) const {
+        int count = std::min(blockSize, length - b * blockSize);
+        const uint32_t* in = words.data() + blockOffset[b];
+#if ALGOS_X86_SIMD && defined(__SSE2__)
+        decodeSse2(in, blockBits[b], blockMin[b], out);
+#else
+        decodeScalar(in, blockBits[b], blockMin[b], out);
+#endif
+        return count;
+    }
+
+private:
+    static constexpr int lanes = 4;
+    static constexpr int rows = blockSize / lanes; // Values per lane
+    static constexpr uint32_t signFlip = 0x80000000u;
+
+    int length;
+    pmr::vector<uint32_t> words;       // Packed deltas of every block, lane-interleaved
+    pmr::vector<uint32_t> blockMin;    // Skip index: first (smallest) key of each block
+    pmr::vector<uint8_t> blockBits;    // Delta bit width of each block, 0-32
+    pmr::vector<uint32_t> blockOffset; // Start of each block in words
+
+    static uint32_t toKey(int value) {
+        return uint32_t(value) ^ signFlip;
+    }
+
+    // Delta j is key[j] - key[j - 4] (key[j] - min for the first row); a short
+    // last block is padded by repeating its last value, i.e. zero deltas.
+    // Lane l packs deltas l, l + 4, l + 8, ... low bits first into b words,
+    // and word w of lane l is stored at 4 * w + l.
+    void encodeBlock(int b, const int values[], int count) {
+        array<uint32_t, blockSize> keys;
+        for (int i = 0; i < blockSize; i++) keys[i] = toKey(values[std::min(i, count - 1)]);
+        array<uint32_t, blockSize> deltas;
+        uint32_t maxDelta = 0;
+        for (int i = 0; i < blockSize; i++) {
+            deltas[i] = keys[i] - (i < lanes ? keys[0] : keys[i - lanes]);
+            maxDelta = std::max(maxDelta, deltas[i]);
+        }
+        int bits = bit_width(maxDelta);
+        blockMin[b] = keys[0];
+        blockBits[b] = uint8_t(bits);
+        blockOffset[b] = uint32_t(words.size());
+        if (bits == 0) return; // Every value equals the minimum
+        words.resize(words.size() + size_t(lanes) * bits, 0);
+        uint32_t* out = words.data() + blockOffset[b];
+        for (int lane = 0; lane < lanes; lane++) {
+            for (int row = 0; row < rows; row++) {
+                uint64_t delta = deltas[row * lanes + lane];
+                int bit = row * bits;
+                int word = bit / 32, shift = bit % 32;
+                out[word * lanes + lane] |= uint32_t(delta << shift);
+                if (shift + bits > 32) {
+                    out[(word + 1) * lanes + lane] |= uint32_t(delta >> (32 - shift));
+                }
+            }
+        }
+    }
+
+    static void decodeScalar(const uint32_t* in, int bits, uint32_t base, int out[]) {
+        uint32_t mask = bits == 32 ? ~0u : (1u << bits) - 1;
+        for (int lane = 0; lane < lanes; lane++) {
+            uint32_t value = base;
+            for (int row = 0; row < rows; row++) {
+                int bit = row * bits;
+                int word = bit / 32, shift = bit % 32;
+                uint64_t packed = bits == 0 ? 0 : in[word * lanes + lane] >> shift;
+                if (shift + bits > 32) packed |= uint64_t(in[(word + 1) * lanes + lane]) << (32 - shift);
+                value += uint32_t(packed) & mask;
+                out[row * lanes + lane] = int(value ^ signFlip);
+            }
+        }
+    }
+
+#if ALGOS_X86_SIMD && defined(__SSE2__)
+    // All four lanes are unpacked and prefix-summed together, one row of
+    // four values per step, reading each packed word exactly once
+    static void decodeSse2(const uint32_t* in, int bits, uint32_t base, int out[]) {
+        __m128i value = _mm_set1_epi32(int(base));
+        __m128i flip = _mm_set1_epi32(int(signFlip));
+        if (bits == 0) {
+            __m128i row = _mm_xor_si128(value, flip);
+            for (int r = 0; r < rows; r++) _mm_storeu_si128(reinterpret_cast<__m128i*>(out + r * lanes), row);
+            return;
+        }
+        __m128i mask = _mm_set1_epi32(bits == 32 ? -1 : int((1u << bits) - 1));
+        const __m128i* packed = reinterpret_cast<const __m128i*>(in);
+        __m128i word = _mm_loadu_si128(packed++);
+        int used = 0; // Bits of word already consumed
+        for (int r = 0; r < rows; r++) {
+            if (used == 32) {
+                word = _mm_loadu_si128(packed++);
+                used = 0;
+            }
+            __m128i delta = _mm_srl_epi32(word, _mm_cvtsi32_si128(used));
+            used += bits;
+            if (used > 32) {
+                // The delta continues in the low bits of the next word
+                word = _mm_loadu_si128(packed++);
+                used -= 32;
+                delta = _mm_or_si128(delta, _mm_sll_epi32(word, _mm_cvtsi32_si128(bits - used)));
+            }
+            value = _mm_add_epi32(value, _mm_and_si128(delta, mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + r * lanes), _mm_xor_si128(value, flip));
+        }
+    }
+#endif
+};
+
+// Runtime CPU feature checks, cached after the first call
+class CpuFeatures {
+public:
+    static bool hasAvx2() {
+#if ALGOS_X86_SIMD
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static bool hasAvx512() {
+#if ALGOS_X86_SIMD
+        static const bool supported = __builtin_cpu_supports("avx512f");
+        return supported;
+#else
+        return false;
+#endif
+    }
+};
+
+// Branch-free sorting kernels for the small partitions at the leaves of
+// quickSort and mergeSort. With AVX2, up to 32 ints are padded into 1-4
+// registers and sorted by bitonic networks of min/max instructions; other
+// CPUs fall back to SortingAlgorithms::insertionSort.
+template <class Instrumentation>
+class BasicSortingAlgorithms;
+
+class SortingNetworks {
+public:
+    static const int maxNetworkSize = 32; // Largest input handled by the networks
+
+    template <class Instrumentation = NoInstrumentation>
+    static void sortSmall(int arr[], int size) {
+        assert(size <= maxNetworkSize);
+#if ALGOS_X86_SIMD
+        if (CpuFeatures::hasAvx2()) {
+            if (size >= 2) {
+                // A bitonic network on p = 2^k lanes has p/2 * k(k+1)/2
+                // compare-exchanges; the input is copied in and back out
+                int padded = paddedSize(size);
+                int k = countr_zero(unsigned(padded));
+                Instrumentation::count(Operation::Comparison, padded / 2 * k * (k + 1) / 2);
+                Instrumentation::count(Operation::Move, 2 * size);
+            }
+            sortSmallAvx2(arr, size);
+            return;
+        }
+#endif
+        BasicSortingAlgorithms<Instrumentation>::insertionSort(arr, size);
+    }
+
+    // Network width used for size elements: 8, 16 or 32
+    static int paddedSize(int size) {
+        return size <= 8 ? 8 : size <= 16 ? 16 : 32;
+    }
+
+#if ALGOS_X86_SIMD
+    // Compare-exchange every lane with lane perm[i]; lanes set in maxLanes keep the max
+    template <int maxLanes>
+    ALGOS_AVX2 static inline __m256i exchange(__m256i v, __m256i perm) {
+        __m256i partner = _mm256_permutevar8x32_epi32(v, perm);
+        return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), maxLanes);
+    }
+
+    // Sort the 8 lanes of one register
+    ALGOS_AVX2 static inline __m256i sort8(__m256i v) {
+        const __m256i swap1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+        const __m256i swap2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+        v = exchange<0x66>(v, swap1);
+        v = exchange<0x3C>(v, swap2);
+        v = exchange<0x5A>(v, swap1);
+        return merge8(v);
+    }
+
+    // Sort a bitonic register into ascending order
+    ALGOS_AVX2 static inline __m256i merge8(__m256i v) {
+        v = exchange<0xF0>(v, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3));
+        v = exchange<0xCC>(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5));
+        return exchange<0xAA>(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6));
+    }
+
+    ALGOS_AVX2 static inline __m256i reverse8(__m256i v) {
+        return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+
+    // Merge two sorted registers: afterwards a holds the 8 smallest values and
+    // b the 8 largest, both sorted
+    ALGOS_AVX2 static inline void merge8x8(__m256i& a, __m256i& b) {
+        __m256i reversed = reverse8(b);
+        __m256i low = _mm256_min_epi32(a, reversed);
+        __m256i high = _mm256_max_epi32(a, reversed);
+        a = merge8(low);
+        b = merge8(high);
+    }
+
+    // Sort a bitonic sequence of 16 held in (a, b)
+    ALGOS_AVX2 static inline void merge16(__m256i& a, __m256i& b) {
+        __m256i low = _mm256_min_epi32(a, b);
+        __m256i high = _mm256_max_epi32(a, b);
+        a = merge8(low);
+        b = merge8(high);
+    }
+
+    ALGOS_AVX2 static inline void sort16(__m256i& a, __m256i& b) {
+        a = sort8(a);
+        b = sort8(b);
+        merge8x8(a, b);
+    }
+
+    ALGOS_AVX2 static inline void sort32(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+        sort16(a, b);
+        sort16(c, d);
+        // Reverse (c, d) so a..d is bitonic, split into lower and upper halves
+        __m256i tail1 = reverse8(d);
+        __m256i tail2 = reverse8(c);
+        __m256i low1 = _mm256_min_epi32(a, tail1), high1 = _mm256_max_epi32(a, tail1);
+        __m256i low2 = _mm256_min_epi32(b, tail2), high2 = _mm256_max_epi32(b, tail2);
+        merge16(low1, low2);
+        merge16(high1, high2);
+        a = low1;
+        b = low2;
+        c = high1;
+        d = high2;
+    }
+
+    // Pad with INT_MAX up to the next network size, sort, and copy back
+    ALGOS_AVX2 static void sortSmallAvx2(int arr[], int size) {
+        if (size < 2) return;
+        alignas(32) int buffer[maxNetworkSize];
+        int padded = paddedSize(size);
+        memcpy(buffer, arr, size * sizeof(int));
+        for (int i = size; i < padded; i++) buffer[i] = INT_MAX;
+
+        __m256i* lanes = reinterpret_cast<__m256i*>(buffer);
+        if (padded == 8) {
+            lanes[0] = sort8(lanes[0]);
+        } else if (padded == 16) {
+            __m256i a = lanes[0], b = lanes[1];
+            sort16(a, b);
+            lanes[0] = a;
+            lanes[1] = b;
+        } else {
+            __m256i a = lanes[0], b = lanes[1], c = lanes[2], d = lanes[3];
+            sort32(a, b, c, d);
+            lanes[0] = a;
+            lanes[1] = b;
+            lanes[2] = c;
+            lanes[3] = d;
+        }
+        memcpy(arr, buffer, size * sizeof(int));
+    }
+#endif
+};
+
+// In-place vectorized partition (Bramas-style). A whole register is compared
+// against the pivot at once and its lanes are compressed so that values
+// <= pivot go to the left write position and values > pivot to the right one.
+// One register from each end is buffered up front, and the next load always
+// comes from the side with less free space, so stores never overwrite
+// unread data.
+class VectorizedPartition {
+public:
+    static bool available() {
+        return CpuFeatures::hasAvx512() || CpuFeatures::hasAvx2();
+    }
+
+    // Same contract as SortingAlgorithms::partition (pivot = arr[high]);
+    // needs at least 32 elements before the pivot. Every element is compared
+    // with the pivot once and written to its side once, then the pivot is
+    // swapped into place; that is what gets reported to Instrumentation.
+    template <class Instrumentation = NoInstrumentation>
+    static int partition(int arr[], int low, int high) {
+        assert(high - low >= 32);
+        Instrumentation::count(Operation::Comparison, high - low);
+        Instrumentation::count(Operation::Move, high - low);
+        Instrumentation::count(Operation::Swap);
+        int split = 0;
+#if ALGOS_X86_SIMD
+        if (CpuFeatures::hasAvx512()) {
+            split = partitionAvx512(arr + low, high - low, arr[high]);
+        } else {
+            split = partitionAvx2(arr + low, high - low, arr[high]);
+        }
+#endif
+        std::swap(arr[low + split], arr[high]);
+        return low + split;
+    }
+
+private:
+#if ALGOS_X86_SIMD
+    // For each 8-bit "lane > pivot" mask, the lane order that puts the
+    // <= pivot lanes first and the > pivot lanes last, packed 4 bits per lane
+    static const uint32_t* permutationTable() {
+        static const auto table = [] {
+            array<uint32_t, 256> entries{};
+            for (int mask = 0; mask < 256; mask++) {
+                uint32_t entry = 0;
+                int slot = 0;
+                for (int side = 0; side < 2; side++) {
+                    for (int lane = 0; lane < 8; lane++) {
+                        if (((mask >> lane) & 1) == side) {
+                            entry |= uint32_t(lane) << (4 * slot++);
+                        }
+                    }
+                }
+                entries[mask] = entry;
+            }
+            return entries;
+        }();
+        return table.data();
+    }
+
+    // Partition base[0, size) around pivot and return the split point
+    ALGOS_AVX2 static int partitionAvx2(int* base, int size, int pivot) {
+        const uint32_t* table = permutationTable();
+        const __m256i pivotVec = _mm256_set1_epi32(pivot);
+        const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+        int leftWrite = 0, rightWrite = size;
+
+        // Send the <= pivot lanes of v to the left side and the rest to the right side
+        auto store = [&](__m256i v, bool last) ALGOS_AVX2 {
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivotVec)));
+            int rightCount = popcount(unsigned(mask));
+            __m256i perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(int(table[mask])), shifts),
+                                            _mm256_set1_epi32(0xF));
+            __m256i packed = _mm256_permutevar8x32_epi32(v, perm);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(base + leftWrite), packed);
+            if (!last) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(base + rightWrite - 8), packed);
+            }
+            leftWrite += 8 - rightCount;
+            rightWrite -= rightCount;
+        };
+
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base));
+        __m256i final = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + size - 8));
+        int leftRead = 8, rightRead = size - 8;
+        while (rightRead - leftRead >= 8) {
+            __m256i v;
+            if (leftRead - leftWrite <= rightWrite - rightRead) {
+                v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + leftRead));
+                leftRead += 8;
+            } else {
+                rightRead -= 8;
+                v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + rightRead));
+            }
+            store(v, false);
+        }
+
+        // Everything unread is now in registers or the remainder, so [leftWrite, rightWrite) is free
+        partitionRemainder(base, leftRead, rightRead, pivot, leftWrite, rightWrite);
+        store(first, false);
+        store(final, true); // Exactly 8 free slots remain
+        return leftWrite;
+    }
+
+    ALGOS_AVX512 static int partitionAvx512(int* base, int size, int pivot) {
+        const __m512i pivotVec = _mm512_set1_epi32(pivot);
+        int leftWrite = 0, rightWrite = size;
+
+        auto store = [&](__m512i v) ALGOS_AVX512 {
+            __mmask16 right = _mm512_cmpgt_epi32_mask(v, pivotVec);
+            int rightCount = popcount(unsigned(right));
+            _mm512_mask_compressstoreu_epi32(base + leftWrite, __mmask16(~right), v);
+            _mm512_mask_compressstoreu_epi32(base + rightWrite - rightCount, right, v);
+            leftWrite += 16 - rightCount;
+            rightWrite -= rightCount;
+        };
+
+        __m512i first = _mm512_loadu_si512(base);
+        __m512i final = _mm512_loadu_si512(base + size - 16);
+        int leftRead = 16, rightRead = size - 16;
+        while (rightRead - leftRead >= 16) {
+            __m512i v;
+            if (leftRead - leftWrite <= rightWrite - rightRead) {
+                v = _mm512_loadu_si512(base + leftRead);
+                leftRead += 16;
+            } else {
+                rightRead -= 16;
+                v = _mm512_loadu_si512(base + rightRead);
+            }
+            store(v);
+        }
+
+        partitionRemainder(base, leftRead, rightRead, pivot, leftWrite, rightWrite);
+        store(first);
+        store(final);
+        return leftWrite;
+    }
+#endif
+
+    // Scalar pass over the fewer-than-one-register leftover between the read positions
+    static void partitionRemainder(int* base, int begin, int end, int pivot, int& leftWrite, int& rightWrite) {
+        int leftover[16];
+        int count = end - begin;
+        memcpy(leftover, base + begin, count * sizeof(int));
+        for (int i = 0; i < count; i++) {
+            if (leftover[i] <= pivot) {
+                base[leftWrite++] = leftover[i];
+            } else {
+                base[--rightWrite] = leftover[i];
+            }
+        }
+    }
+};
+
+// Set operations on sorted int arrays with no duplicates (for example id
+// lists after sortUnique). Each call writes its result, also sorted, to out
+// and returns the number of values written. The strategy follows the size
+// ratio: when one input is much smaller, each of its values is located in
+// the other by galloping (exponential then binary search), so the cost grows
+// with the small input only. For similar sizes, intersect and difference go
+// through an AVX2 8x8 block compare (a plain merge without AVX2); unite
+// writes every input value anyway and always uses a branch-free scalar merge.
+class SetOperations {
+public:
+    static constexpr int gallopRatio = 32; // Larger / smaller size from which to gallop
+
+    // Values in both a and b; out needs room for min(sizeA, sizeB) values
+    static int intersect(const int a[], int sizeA, const int b[], int sizeB, int out[]) {
+        assert(sizeA >= 0 && sizeB >= 0);
+        if (sizeA > sizeB) {
+            std::swap(a, b);
+            std::swap(sizeA, sizeB);
+        }
+        if (sizeA == 0) return 0;
+        if (sizeB / sizeA >= gallopRatio) {
+            return gallopMatches<true>(a, sizeA, b, sizeB, out);
+        }
+#if ALGOS_X86_SIMD
+        if (CpuFeatures::hasAvx2()) {
+            return blockCompareAvx2<true>(a, sizeA, b, sizeB, out);
+        }
+#endif
+        return mergeMatches<true>(a, sizeA, 0, b, sizeB, 0, out, 0);
+    }
+
+    // Values in a that are not in b; out needs room for sizeA values
+    static int difference(const int a[], int sizeA, const int b[], int sizeB, int out[]) {
+        assert(sizeA >= 0 && sizeB >= 0);
+        if (sizeA == 0) return 0;
+        if (sizeB == 0 || sizeA / sizeB >= gallopRatio) {
+            return gallopCopy(a, sizeA, b, sizeB, out, false);
+        }
+        if (sizeB / sizeA >= gallopRatio) {
+            return gallopMatches<false>(a, sizeA, b, sizeB, out);
+        }
+#if ALGOS_X86_SIMD
+        if (CpuFeatures::hasAvx2()) {
+            return blockCompareAvx2<false>(a, sizeA, b, sizeB, out);
+        }
+#endif
+        return mergeMatches<false>(a, sizeA, 0, b, sizeB, 0, out, 0);
+    }
+
+    // Values in a or b; out needs room for sizeA + sizeB values. Every input
+    // value is written out, so for skewed sizes the large input is copied in
+    // runs between the positions of the small one's values.
+    static int unite(const int a[], int sizeA, const int b[], int sizeB, int out[]) {
+        assert(sizeA >= 0 && sizeB >= 0);
+        if (sizeA < sizeB) {
+            std::swap(a, b);
+            std::swap(sizeA, sizeB);
+        }
+        if (sizeB == 0 || sizeA / sizeB >= gallopRatio) {
+            return gallopCopy(a, sizeA, b, sizeB, out, true);
+        }
+        int i = 0, j = 0, n = 0;
+        while (i < sizeA && j < sizeB) {
+            int x = a[i], y = b[j];
+            out[n++] = std::min(x, y);
+            i += x <= y;
+            j += y <= x;
+        }
+        while (i < sizeA) out[n++] = a[i++];
+        while (j < sizeB) out[n++] = b[j++];
+        return n;
+    }
+
+    // Values in every list, smallest lists first so the running result only
+    // shrinks; out needs room for the smallest list. Scratch space comes from resource.
+    static int intersectMany(const vector<span<const int>>& lists, int out[],
+                             pmr::memory_resource* resource = pmr::get_default_resource()) {
+        if (lists.empty()) return 0;
+        pmr::vector<span<const int>> order(lists.begin(), lists.end(), resource);
+        std::sort(order.begin(), order.end(), [](span<const int> x, span<const int> y) { return x.size() < y.size(); });
+        int n = int(order[0].size());
+        std::copy(order[0].begin(), order[0].end(), out);
+        pmr::vector<int> scratch(n, resource);
+        for (size_t k = 1; k < order.size() && n > 0; k++) {
+            n = intersect(out, n, order[k].data(), int(order[k].size()), scratch.data());
+            std::copy(scratch.begin(), scratch.begin() + n, out);
+        }
+        return n;
+    }
+
+private:
+    // First index at or after from whose value is >= target (size if none),
+    // probing from + 1, + 2, + 4, ... before a binary search of the last step
+    static int gallop(const int arr[], int size, int from, int target) {
+        if (from >= size || arr[from] >= target) return from;
+        int step = 1;
+        int low = from; // arr[low] < target throughout
+        while (low + step < size && arr[low + step] < target) {
+            low += step;
+            step *= 2;
+        }
+        int high = std::min(low + step, size);
+        return int(std::lower_bound(arr + low + 1, arr + high, target) - arr);
+    }
+
+    // The values of small that are (keepMatches) or are not in large
+    template <bool keepMatches>
+    static int gallopMatches(const int small[], int sizeSmall, const int large[], int sizeLarge, int out[]) {
+        int n = 0, pos = 0;
+        for (int i = 0; i < sizeSmall; i++) {
+            pos = gallop(large, sizeLarge, pos, small[i]);
+            bool found = pos < sizeLarge && large[pos] == small[i];
+            if (found == keepMatches) out[n++] = small[i];
+        }
+        return n;
+    }
+
+    // Copy large to out in runs, placing each value of small in its slot
+    // (unite) or dropping the values of large equal to one of small (difference)
+    static int gallopCopy(const int large[], int sizeLarge, const int small[], int sizeSmall, int out[], bool unite) {
+        int n = 0, pos = 0;
+        for (int j = 0; j < sizeSmall; j++) {
+            int next = gallop(large, sizeLarge, pos, small[j]);
+            std::copy(large + pos, large + next, out + n);
+            n += next - pos;
+            pos = next;
+            bool found = pos < sizeLarge && large[pos] == small[j];
+            if (found) pos++; // Written below for unite, dropped for difference
+            if (unite) out[n++] = small[j];
+        }
+        std::copy(large + pos, large + sizeLarge, out + n);
+        return n + (sizeLarge - pos);
+    }
+
+    // Scalar merge from a[i], b[j] writing from out[n]
+    template <bool keepMatches>
+    static int mergeMatches(const int a[], int sizeA, int i, const int b[], int sizeB, int j, int out[], int n) {
+        while (i < sizeA && j < sizeB) {
+            if (a[i] < b[j]) {
+                if (!keepMatches) out[n++] = a[i];
+                i++;
+            } else if (b[j] < a[i]) {
+                j++;
+            } else {
+                if (keepMatches) out[n++] = a[i];
+                i++;
+                j++;
+            }
+        }
+        if (!keepMatches) {
+            while (i < sizeA) out[n++] = a[i++];
+        }
+        return n;
+    }
+
+#if ALGOS_X86_SIMD
+    // Compare 8 values of a with 8 values of b all at once: b is rotated
+    // through all 8 lane offsets, so the match mask of the a block collects
+    // every equal pair. The block with the smaller last value is done after
+    // that and moves on; an a block emits its matched (intersect) or
+    // unmatched (difference) lanes when it moves on.
+    template <bool keepMatches>
+    ALGOS_AVX2 static int blockCompareAvx2(const int a[], int sizeA, const int b[], int sizeB, int out[]) {
+        const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        int i = 0, j = 0, n = 0;
+        unsigned matched = 0; // Lanes of the a block at i matched so far
+        while (i + 8 <= sizeA && j + 8 <= sizeB) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+            __m256i eq = _mm256_cmpeq_epi32(va, vb);
+            for (int r = 1; r < 8; r++) {
+                vb = _mm256_permutevar8x32_epi32(vb, rotate);
+                eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+            }
+            matched |= unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+            int lastA = a[i + 7], lastB = b[j + 7];
+            if (lastA <= lastB) {
+                for (unsigned lanes = keepMatches ? matched : ~matched & 0xFF; lanes != 0; lanes &= lanes - 1) {
+                    out[n++] = a[i + countr_zero(lanes)];
+                }
+                matched = 0;
+                i += 8;
+            }
+            if (lastB <= lastA) j += 8;
+        }
+        // b ran out with an a block part way through: finish its lanes one by one
+        if (matched != 0) {
+            for (int lane = 0; lane < 8; lane++) {
+                bool found = (matched >> lane) & 1;
+                if (!found) {
+                    while (j < sizeB && b[j] < a[i + lane]) j++;
+                    found = j < sizeB && b[j] == a[i + lane];
+                }
+                if (found == keepMatches) out[n++] = a[i + lane];
+            }
+            i += 8;
+        }
+        return mergeMatches<keepMatches>(a, sizeA, i, b, sizeB, j, out, n);
+    }
+#endif
+};
+
+// Sorting algorithms
+template <class Instrumentation = NoInstrumentation>
+class BasicSortingAlgorithms {
+    using Helper = BasicArrayHelper<Instrumentation>;
+
+public:
+    static void bubbleSort(int arr[], int size) {
+        bool swapped;
+        for (int i = 0; i < size - 1; i++) {
+            swapped = false;
+            for (int j = 0; j < size - i - 1; j++) {
+                Instrumentation::count(Operation::Comparison);
+                if (arr[j] > arr[j + 1]) {
+                    Helper::swap(arr, j, j + 1);
+                    swapped = true;
+                }
+            }
+            if (!swapped) {
+                break;
+            }
+        }
+    }
+//--------------------------------------------------------->
+
+    static void selectionSort(int arr[], int size) {
+        for (int i = 0; i < size - 1; i++) {
+            int min_idx = i;
+            for (int j = i + 1; j < size; j++) {
+                Instrumentation::count(Operation::Comparison);
+                if (arr[j] < arr[min_idx]) {
+                    min_idx = j;
+                }
+            }
+            if (min_idx != i) {
+                Helper::swap(arr, i, min_idx);
+            }
+        }
+    }
+//--------------------------------------------------------->
+
+    static void insertionSort(int arr[], int size) {
+        for (int i = 1; i < size; i++) {
+            int key = arr[i];
+            int j = i - 1;
+            while (j >= 0) {
+                Instrumentation::count(Operation::Comparison);
+                if (arr[j] <= key) break;
+                arr[j + 1] = arr[j];
+                Instrumentation::count(Operation::Move);
+                j--;
+            }
+            arr[j + 1] = key;
+        }
+    }
+//--------------------------------------------------------->
+
+    // The temporary arrays come from resource, so an arena can serve a whole sort
+    static void merge(int arr[], int left, int mid, int right,
+                      pmr::memory_resource* resource = pmr::get_default_resource()) {
+        int n1 = mid - left + 1;
+        int n2 = right - mid;
+
+        // Create temporary arrays
+        int* L = static_cast<int*>(resource->allocate(n1 * sizeof(int), alignof(int)));
+        int* R = static_cast<int*>(resource->allocate(n2 * sizeof(int), alignof(int)));
+        Instrumentation::count(Operation::Allocation, 2);
+        Instrumentation::count(Operation::Move, 2 * (n1 + n2));
+
+        // Copy data to temporary arrays
+        for (int i = 0; i < n1; i++)
+            L[i] = arr[left + i];
+        for (int j = 0; j < n2; j++)
+            R[j] = arr[mid + 1 + j];
+
+        // Merge the temporary arrays back into arr
+        int i = 0, j = 0, k = left;
+        while (i < n1 && j < n2) {
+            Instrumentation::count(Operation::Comparison);
+            if (L[i] <= R[j]) {
+                arr[k] = L[i];
+                i++;
+            } else {
+                arr[k] = R[j];
+                j++;
+            }
+            k++;
+        }
+
+        // Copy remaining elements of L[]
+        while (i < n1) {
+            arr[k] = L[i];
+            i++;
+            k++;
+        }
+
+        // Copy remaining elements of R[]
+        while (j < n2) {
+            arr[k] = R[j];
+            j++;
+            k++;
+        }
+
+        // Free temporary arrays
+        resource->deallocate(L, n1 * sizeof(int), alignof(int));
+        resource->deallocate(R, n2 * sizeof(int), alignof(int));
+    }
+
+    static void mergeSortHelper(int arr[], int left, int right,
+                                pmr::memory_resource* resource = pmr::get_default_resource()) {
+        if (right - left < SortingNetworks::maxNetworkSize) {
+            SortingNetworks::sortSmall<Instrumentation>(arr + left, right - left + 1);
+        } else {
+            int mid = left + (right - left) / 2;
+            mergeSortHelper(arr, left, mid, resource);
+            mergeSortHelper(arr, mid + 1, right, resource);
+            merge(arr, left, mid, right, resource);
+        }
+    }
+
+    static void mergeSort(int arr[], int size, pmr::memory_resource* resource = pmr::get_default_resource()) {
+        mergeSortHelper(arr, 0, size - 1, resource);
+    }
+//--------------------------------------------------------->
+
+    static int partition(int arr[], int low, int high) {
+        int pivot = arr[high];
+        int i = low - 1;
+
+        for (int j = low; j < high; j++) {
+            Instrumentation::count(Operation::Comparison);
+            if (arr[j] <= pivot) {
+                i++;
+                Helper::swap(arr, i, j);
+            }
+        }
+        Helper::swap(arr, i + 1, high);
+        return i + 1;
+    }
+
+    static void quickSortHelper(int arr[], int low, int high) {
+        if (high - low < SortingNetworks::maxNetworkSize) {
+            SortingNetworks::sortSmall<Instrumentation>(arr + low, high - low + 1);
+        } else {
+            int pi = partitionRange(arr, low, high);
+            quickSortHelper(arr, low, pi - 1);
+            quickSortHelper(arr, pi + 1, high);
+        }
+    }
+
+    static void quickSort(int arr[], int size) {
+        quickSortHelper(arr, 0, size - 1);
+    }
+  //--------------------------------------------------------->
+
+    // Adaptive entry point: inspects the input and hands it to the engine
+    // that suits its shape. Defined after ParallelSort, which it can use.
+    // Scratch space comes from resource, except inside the parallel sort.
+    static void sort(int arr[], int size, pmr::memory_resource* resource = pmr::get_default_resource());
+
+    // Log one line per sort() call with the measured shape and the engine
+    // chosen (nullptr turns logging off)
+    static void setDecisionLog(ostream* log) {
+        decisionLog = log;
+    }
+//--------------------------------------------------------->
+
+    // Counting sort for values known to lie in [minValue, maxValue]; O(n + range)
+    static void countingSort(int arr[], int size, int minValue, int maxValue,
+                             pmr::memory_resource* resource = pmr::get_default_resource()) {
+        pmr::vector<int> counts(size_t(int64_t(maxValue) - minValue) + 1, 0, resource);
+        Instrumentation::count(Operation::Allocation);
+        Instrumentation::count(Operation::Move, size); // Every value is written back once
+        for (int i = 0; i < size; i++) {
+            counts[size_t(int64_t(arr[i]) - minValue)]++;
+        }
+        int k = 0;
+        for (size_t v = 0; v < counts.size(); v++) {
+            for (int c = counts[v]; c > 0; c--) {
+                arr[k++] = int(int64_t(minValue) + int64_t(v));
+            }
+        }
+    }
+//--------------------------------------------------------->
+
+    // 3-way (Dijkstra) quicksort: keys equal to the pivot are finished in the
+    // same pass, so inputs with many duplicates take O(n log d) for d distinct keys
+    static void quickSort3Way(int arr[], int size) {
+        quickSort3WayHelper(arr, 0, size - 1);
+    }
+
+    static void quickSort3WayHelper(int arr[], int low, int high) {
+        while (high - low >= SortingNetworks::maxNetworkSize) {
+            int mid = low + (high - low) / 2;
+            int pivot = medianOfThree(arr[low], arr[mid], arr[high]);
+            int lt = low, i = low, gt = high;
+            while (i <= gt) {
+                Instrumentation::count(Operation::Comparison);
+                if (arr[i] < pivot) {
+                    Helper::swap(arr, lt++, i++);
+                    continue;
+                }
+                Instrumentation::count(Operation::Comparison);
+                if (arr[i] > pivot) {
+                    Helper::swap(arr, i, gt--);
+                } else {
+                    i++;
+                }
+            }
+            // Recurse into the smaller side, loop on the larger one
+            if (lt - low < high - gt) {
+                quickSort3WayHelper(arr, low, lt - 1);
+                low = gt + 1;
+            } else {
+                quickSort3WayHelper(arr, gt + 1, high);
+                high = lt - 1;
+            }
+        }
+        SortingNetworks::sortSmall<Instrumentation>(arr + low, high - low + 1);
+    }
+//--------------------------------------------------------->
+
+    // Generic sorts over span<T>. Elements are ordered by comp(proj(a), proj(b)),
+    // so records can be sorted by a member (e.g. &PersonData::hireDate) in place.
+    // Where the element and key types allow it, faster kernels are picked at
+    // compile time: memmove shifts for trivially copyable elements and radix
+    // sort for arithmetic keys under their natural order.
+
+    // Key type produced by proj for an element of type T
+    template <class T, class Proj>
+    using KeyOf = remove_cvref_t<invoke_result_t<Proj&, T&>>;
+
+    // comp is plain "<" (or ">") on Key, so ordering depends only on the key bits
+    template <class Compare, class Key>
+    static constexpr bool isNaturalLess =
+        is_same_v<Compare, ranges::less> || is_same_v<Compare, less<>> || is_same_v<Compare, less<Key>>;
+    template <class Compare, class Key>
+    static constexpr bool isNaturalGreater =
+        is_same_v<Compare, ranges::greater> || is_same_v<Compare, greater<>> || is_same_v<Compare, greater<Key>>;
+
+    // Keys radixSort can map to a 1-8 byte unsigned integer; long double and
+    // __int128 keys go through the comparison sorts instead
+    template <class T, class Compare, class Proj>
+    static constexpr bool radixSortable =
+        is_arithmetic_v<KeyOf<T, Proj>> && !is_same_v<KeyOf<T, Proj>, bool> &&
+        !is_same_v<KeyOf<T, Proj>, long double> &&
+        (sizeof(KeyOf<T, Proj>) == 1 || sizeof(KeyOf<T, Proj>) == 2 ||
+         sizeof(KeyOf<T, Proj>) == 4 || sizeof(KeyOf<T, Proj>) == 8) &&
+        (isNaturalLess<Compare, KeyOf<T, Proj>> || isNaturalGreater<Compare, KeyOf<T, Proj>>);
+
+    static constexpr size_t smallSortThreshold = 16;  // Insertion sort below this
+    static constexpr size_t radixSortThreshold = 256; // Radix passes don't pay off below this
+
+    template <class T, class Compare = ranges::less, class Proj = identity>
+    static void bubbleSort(span<T> arr, Compare comp = {}, Proj proj = {}) {
+        for (size_t i = 0; i + 1 < arr.size(); i++) {
+            bool swapped = false;
+            for (size_t j = 0; j + 1 < arr.size() - i; j++) {
+                if (compare(comp, proj, arr[j + 1], arr[j])) {
+                    Helper::swap(arr, j, j + 1);
+                    swapped = true;
+                }
+            }
+            if (!swapped) {
+                break;
+            }
+        }
+    }
+//--------------------------------------------------------->
+
+    template <class T, class Compare = ranges::less, class Proj = identity>
+    static void selectionSort(span<T> arr, Compare comp = {}, Proj proj = {}) {
+        for (size_t i = 0; i + 1 < arr.size(); i++) {
+            size_t min_idx = i;
+            for (size_t j = i + 1; j < arr.size(); j++) {
+                if (compare(comp, proj, arr[j], arr[min_idx])) {
+                    min_idx = j;
+                }
+            }
+            if (min_idx != i) {
+                Helper::swap(arr, i, min_idx);
+            }
+        }
+    }
+//--------------------------------------------------------->
+
+    template <class T, class Compare = ranges::less, class Proj = identity>
+    static void insertionSort(span<T> arr, Compare comp = {}, Proj proj = {}) {
+        for (size_t i = 1; i < arr.size(); i++) {
+            if (!compare(comp, proj, arr[i], arr[i - 1])) {
+                continue; // Already in place
+            }
+            T key = std::move(arr[i]);
+            if constexpr (is_trivially_copyable_v<T>) {
+                // Binary-search the slot, then shift the block with one memmove
+                size_t left = 0, right = i - 1;
+                while (left < right) {
+                    size_t mid = left + (right - left) / 2;
+                    if (compare(comp, proj, key, arr[mid])) {
+                        right = mid;
+                    } else {
+                        left = mid + 1;
+                    }
+                }
+                memmove(&arr[left + 1], &arr[left], (i - left) * sizeof(T));
+                arr[left] = key;
+            } else {
+                size_t j = i;
+                while (j > 0 && compare(comp, proj, key, arr[j - 1])) {
+                    arr[j] = std::move(arr[j - 1]);
+                    j--;
+                }
+                arr[j] = std::move(key);
+            }
+        }
+    }
+//--------------------------------------------------------->
+
+    // Stable. Arithmetic keys in natural order go through radixSort instead,
+    // except floating-point keys that include a NaN: those have no strict weak
+    // order, so they get the comparison sort the caller asked for.
+    // The scratch buffer is allocated from resource.
+    template <class T, class Compare = ranges::less, class Proj = identity>
+    static void mergeSort(span<T> arr, Compare comp = {}, Proj proj = {},
+                          pmr::memory_resource* resource = pmr::get_default_resource()) {
+        if constexpr (radixSortable<T, Compare, Proj>) {
+            if (arr.size() >= radixSortThreshold && !hasNaNKey(arr, proj)) {
+                radixSort(arr, proj, isNaturalGreater<Compare, KeyOf<T, Proj>>, resource);
+                return;
+            }
+        }
+        if (arr.size() < 2) return;
+        pmr::vector<T> buffer(arr.begin(), arr.end(), resource); // One scratch buffer for the whole sort
+        Instrumentation::count(Operation::Allocation);
+        mergeSortHelper(arr, span<T>(buffer), comp, proj);
+    }
+
+    template <class T, class Compare, class Proj>
+    static void mergeSortHelper(span<T> arr, span<T> buffer, Compare& comp, Proj& proj) {
+        if (arr.size() <= smallSortThreshold) {
+            insertionSort(arr, comp, proj);
+            return;
+        }
+        size_t mid = arr.size() / 2;
+        mergeSortHelper(arr.first(mid), buffer.first(mid), comp, proj);
+        mergeSortHelper(arr.subspan(mid), buffer.subspan(mid), comp, proj);
+
+        // Merge both halves into the buffer, then move the result back
+        size_t i = 0, j = mid, k = 0;
+        while (i < mid && j < arr.size()) {
+            if (compare(comp, proj, arr[j], arr[i])) {
+                buffer[k++] = std::move(arr[j++]);
+            } else {
+                buffer[k++] = std::move(arr[i++]); // Ties take the left element first
+            }
+        }
+        while (i < mid) buffer[k++] = std::move(arr[i++]);
+        while (j < arr.size()) buffer[k++] = std::move(arr[j++]);
+        std::move(buffer.begin(), buffer.begin() + k, arr.begin());
+    }
+//--------------------------------------------------------->
+
+    // Median-of-three quicksort with a Hoare-style partition (equal keys are
+    // split evenly, so runs of duplicates don't degrade it)
+    template <class T, class Compare = ranges::less, class Proj = identity>
+    static void quickSort(span<T> arr, Compare comp = {}, Proj proj = {}) {
+        while (arr.size() > smallSortThreshold) {
+            size_t pi = partition(arr, comp, proj);
+            // Recurse into the smaller side, loop on the larger one
+            if (pi < arr.size() - pi) {
+                quickSort(arr.first(pi), comp, proj);
+                arr = arr.subspan(pi + 1);
+            } else {
+                quickSort(arr.subspan(pi + 1), comp, proj);
+                arr = arr.first(pi);
+            }
+        }
+        insertionSort(arr, comp, proj);
+    }
+
+    // Partition around the median of first, middle and last; returns the pivot's final index
+    template <class T, class Compare, class Proj>
+    static size_t partition(span<T> arr, Compare& comp, Proj& proj) {
+        size_t high = arr.size() - 1, mid = high / 2;
+        auto less = [&](size_t a, size_t b) { return compare(comp, proj, arr[a], arr[b]); };
+        if (less(mid, 0)) Helper::swap(arr, mid, 0);
+        if (less(high, 0)) Helper::swap(arr, high, 0);
+        if (less(mid, high)) Helper::swap(arr, mid, high);
+
+        // The pivot stays at arr[high] until the final swap
+        size_t i = 0, j = high;
+        while (true) {
+            while (less(i, high)) i++;
+            while (j > 0 && less(high, --j)) {}
+            if (i >= j) break;
+            Helper::swap(arr, i++, j);
+        }
+        Helper::swap(arr, i, high);
+        return i;
+    }
+//--------------------------------------------------------->
+
+    // LSD radix sort on an arithmetic key, one byte per pass. Stable.
+    // Signed and floating-point keys are mapped to unsigned integers that sort
+    // in the same order; passes where every key has the same byte are skipped.
+    // -0.0 and +0.0 are equal keys, as they are to operator<. NaNs sort by bit
+    // pattern: those with the sign bit set first, the rest last.
+    // The scratch buffer is allocated from resource.
+    template <class T, class Proj = identity>
+    static void radixSort(span<T> arr, Proj proj = {}, bool descending = false,
+                          pmr::memory_resource* resource = pmr::get_default_resource()) {
+        if (arr.size() < 2) return;
+        pmr::vector<T> buffer(arr.begin(), arr.end(), resource);
+        Instrumentation::count(Operation::Allocation);
+        radixSort(arr, span<T>(buffer), proj, descending);
+    }
+
+    // Same, using the caller's scratch space (at least arr.size() elements)
+    template <class T, class Proj = identity>
+    static void radixSort(span<T> arr, span<T> scratch, Proj proj = {}, bool descending = false) {
+        assert(scratch.size() >= arr.size());
+        using Key = KeyOf<T, Proj>;
+        static_assert(is_arithmetic_v<Key>, "radixSort needs an arithmetic key");
+        using Bits = conditional_t<sizeof(Key) == 1, uint8_t,
+                     conditional_t<sizeof(Key) == 2, uint16_t,
+                     conditional_t<sizeof(Key) == 4, uint32_t, uint64_t>>>;
+        static_assert(sizeof(Bits) == sizeof(Key), "unsupported key width");
+        constexpr int passes = sizeof(Key);
+        constexpr Bits signBit = Bits(Bits(1) << (8 * sizeof(Bits) - 1));
+
+        auto radixKey = [&](const T& element) -> Bits {
+            Key key = invoke(proj, element);
+            if constexpr (is_floating_point_v<Key>) {
+                if (key == Key(0)) key = Key(0); // Fold -0.0 into +0.0
+            }
+            Bits bits;
+            memcpy(&bits, &key, sizeof(Key));
+            if constexpr (is_floating_point_v<Key>) {
+                bits = (bits & signBit) ? Bits(~bits) : Bits(bits | signBit);
+            } else if constexpr (is_signed_v<Key>) {
+                bits ^= signBit;
+            }
+            return descending ? Bits(~bits) : bits;
+        };
+
+        size_t n = arr.size();
+        if (n < 2) return;
+
+        // Histogram every digit in a single read of the input
+        array<size_t, passes * 256> counts{};
+        for (const T& element : arr) {
+            Bits bits = radixKey(element);
+            for (int pass = 0; pass < passes; pass++) {
+                counts[pass * 256 + ((bits >> (8 * pass)) & 0xFF)]++;
+            }
+        }
+
+        T* src = arr.data();
+        T* dst = scratch.data();
+        for (int pass = 0; pass < passes; pass++) {
+            size_t* count = &counts[pass * 256];
+            if (count[(radixKey(src[0]) >> (8 * pass)) & 0xFF] == n) {
+                continue; // Every key has the same digit here
+            }
+            size_t offset = 0;
+            for (int digit = 0; digit < 256; digit++) {
+                size_t c = count[digit];
+                count[digit] = offset;
+                offset += c;
+            }
+            Instrumentation::count(Operation::Move, long(n)); // One scatter per element
+            for (size_t i = 0; i < n; i++) {
+                dst[count[(radixKey(src[i]) >> (8 * pass)) & 0xFF]++] = std::move(src[i]);
+            }
+            std::swap(src, dst);
+        }
+        if (src != arr.data()) {
+            Instrumentation::count(Operation::Move, long(n));
+            std::move(src, src + n, arr.data());
+        }
+    }
+  //--------------------------------------------------------->
+
+private:
+    static inline ostream* decisionLog = nullptr;
+
+    // Thresholds used by sort()
+    static constexpr int adaptiveMaxMergeRuns = 16;     // Up to this many ascending runs: merge the runs
+    static constexpr int adaptiveSampleSize = 128;      // Elements sampled to estimate the duplicate ratio
+    static constexpr int adaptiveParallelMin = 1 << 22; // Below this, threads don't pay for themselves
+
+    // Whether any key is a floating-point NaN (never, for other key types)
+    template <class T, class Proj>
+    static bool hasNaNKey(span<T> arr, Proj& proj) {
+        if constexpr (is_floating_point_v<KeyOf<T, Proj>>) {
+            return ranges::any_of(arr, [&](const T& element) { return isnan(invoke(proj, element)); });
+        } else {
+            return false;
+        }
+    }
+
+    // comp(proj(a), proj(b)), reported to the instrumentation as one comparison
+    template <class Compare, class Proj, class A, class B>
+    static bool compare(Compare& comp, Proj& proj, const A& a, const B& b) {
+        Instrumentation::count(Operation::Comparison);
+        return invoke(comp, invoke(proj, a), invoke(proj, b));
+    }
+
+    // Vectorized partition when the CPU has it
+    static int partitionRange(int arr[], int low, int high) {
+        if (!VectorizedPartition::available()) {
+            return partition(arr, low, high);
+        }
+        return VectorizedPartition::partition<Instrumentation>(arr, low, high);
+    }
+
+    static int medianOfThree(int a, int b, int c) {
+        Instrumentation::count(Operation::Comparison, 3);
+        return std::max(std::min(a, b), std::min(std::max(a, b), c));
+    }
+
+    // Quicksort with median-of-three pivots and a recursion budget of about
+    // 2 log2(n); a range that uses up its budget is finished by merge sort,
+    // so no input pattern can make it quadratic
+    static void introSortHelper(int arr[], int low, int high, int depthBudget, pmr::memory_resource* resource) {
+        while (high - low >= SortingNetworks::maxNetworkSize) {
+            if (depthBudget-- == 0) {
+                mergeSort(span<int>(arr + low, size_t(high - low + 1)), {}, {}, resource);
+                return;
+            }
+            int mid = low + (high - low) / 2;
+            Instrumentation::count(Operation::Comparison, 3); // Median of three
+            if (arr[mid] < arr[low]) Helper::swap(arr, mid, low);
+            if (arr[high] < arr[low]) Helper::swap(arr, high, low);
+            if (arr[mid] < arr[high]) Helper::swap(arr, mid, high);
+            int pi = partitionRange(arr, low, high);
+            if (pi - low < high - pi) {
+                introSortHelper(arr, low, pi - 1, depthBudget, resource);
+                low = pi + 1;
+            } else {
+                introSortHelper(arr, pi + 1, high, depthBudget, resource);
+                high = pi - 1;
+            }
+        }
+        SortingNetworks::sortSmall<Instrumentation>(arr + low, high - low + 1);
+    }
+
+    // Insertion sort that gives up after maxMoves element moves; returns
+    // whether it finished (the array is a permutation of the input either way)
+    static bool boundedInsertionSort(int arr[], int size, long maxMoves) {
+        long moves = 0;
+        for (int i = 1; i < size; i++) {
+            int key = arr[i];
+            int j = i - 1;
+            while (j >= 0) {
+                Instrumentation::count(Operation::Comparison);
+                if (arr[j] <= key) break;
+                arr[j + 1] = arr[j];
+                Instrumentation::count(Operation::Move);
+                j--;
+            }
+            arr[j + 1] = key;
+            moves += i - 1 - j;
+            if (moves > maxMoves) return false;
+        }
+        return true;
+    }
+
+    // Merge the ascending runs of arr pairwise until one run is left
+    static void mergeRuns(int arr[], int size, pmr::memory_resource* resource) {
+        pmr::vector<int> runStart(resource);
+        Instrumentation::count(Operation::Allocation);
+        Instrumentation::count(Operation::Comparison, size - 1); // Finding the run boundaries
+        for (int i = 0; i < size; i++) {
+            if (i == 0 || arr[i - 1] > arr[i]) runStart.push_back(i);
+        }
+        while (runStart.size() > 1) {
+            pmr::vector<int> merged(resource);
+            Instrumentation::count(Operation::Allocation);
+            for (size_t r = 0; r < runStart.size(); r += 2) {
+                merged.push_back(runStart[r]);
+                if (r + 1 < runStart.size()) {
+                    int end = r + 2 < runStart.size() ? runStart[r + 2] : size;
+                    merge(arr, runStart[r], runStart[r + 1] - 1, end - 1, resource);
+                }
+            }
+            runStart = merged;
+        }
+    }
+
+};
+
+using SortingAlgorithms = BasicSortingAlgorithms<>;
+
+// Selection algorithms: order statistics without sorting everything.
+// All of them are built on the same partition step quickSort uses.
+template <class Instrumentation = NoInstrumentation>
+class BasicSelectionAlgorithms {
+    using Helper = BasicArrayHelper<Instrumentation>;
+    using Sorting = BasicSortingAlgorithms<Instrumentation>;
+
+public:
+    static const int heapTopKLimit = 1024; // Above this k, select-then-sort beats a heap
+
+    // Rearrange arr so arr[k] is the value it would have after sorting, everything
+    // before it is <= arr[k] and everything after it is >= arr[k]. Introselect:
+    // median-of-three pivots, falling back to median-of-medians pivots (worst
+    // case O(n)) when the range stops shrinking fast enough.
+    static void nthElement(int arr[], int size, int k) {
+        if (size <= 0) return;
+        assert(k >= 0 && k < size);
+        select(arr, 0, size - 1, k, false);
+    }
+
+    // Median (the upper one for even sizes); reorders arr
+    static int median(int arr[], int size) {
+        assert(size > 0);
+        nthElement(arr, size, size / 2);
+        return arr[size / 2];
+    }
+//--------------------------------------------------------->
+
+    // Put the k smallest values, in ascending order, at the front of arr.
+    // The rest of arr is left in unspecified order.
+    static void partialSort(int arr[], int size, int k) {
+        k = std::min(k, size);
+        if (k <= 0) return;
+        if (k <= heapTopKLimit) {
+            // Max-heap of the k smallest so far: O(n log k)
+            for (int i = k / 2 - 1; i >= 0; i--) siftDown(arr, k, i, greaterThan);
+            for (int i = k; i < size; i++) {
+                if (greaterThan(arr[0], arr[i])) {
+                    Helper::swap(arr, 0, i);
+                    siftDown(arr, k, 0, greaterThan);
+                }
+            }
+            heapSort(arr, k, greaterThan);
+        } else {
+            // O(n) selection, then sort only the front
+            nthElement(arr, size, k - 1);
+            Sorting::mergeSort(span<int>(arr, k));
+        }
+    }
+
+    // Copy the k largest values of arr into out in descending order, leaving arr untouched.
+    // Returns how many values were written (min(k, size)). Scratch space comes from resource.
+    static int topK(const int arr[], int size, int k, int out[],
+                    pmr::memory_resource* resource = pmr::get_default_resource()) {
+        k = std::min(k, size);
+        if (k <= 0) return 0;
+        if (k <= heapTopKLimit) {
+            StreamingTopK stream(k, resource);
+            stream.add(arr, size);
+            return stream.result(out);
+        }
+        pmr::vector<int> copy(arr, arr + size, resource);
+        Instrumentation::count(Operation::Allocation);
+        Instrumentation::count(Operation::Move, size);
+        nthElement(copy.data(), size, size - k);
+        std::copy(copy.begin() + (size - k), copy.end(), out);
+        Sorting::mergeSort(span<int>(out, k), ranges::greater{}, {}, resource);
+        return k;
+    }
+//--------------------------------------------------------->
+
+    // Running top-k over data that arrives in chunks: keeps a min-heap of the k
+    // largest values seen, so memory is O(k) whatever the stream length.
+    class StreamingTopK {
+    public:
+        explicit StreamingTopK(int k, pmr::memory_resource* resource = pmr::get_default_resource())
+            : k(std::max(k, 0)), heap(resource) {
+            heap.reserve(this->k);
+            Instrumentation::count(Operation::Allocation);
+        }
+
+        void add(const int chunk[], int size) {
+            for (int i = 0; i < size; i++) {
+                if (int(heap.size()) < k) {
+                    heap.push_back(chunk[i]);
+                    siftUp(heap.data(), int(heap.size()) - 1, lessThan);
+                } else if (k > 0 && lessThan(heap[0], chunk[i])) {
+                    heap[0] = chunk[i]; // Replace the smallest kept value
+                    siftDown(heap.data(), k, 0, lessThan);
+                }
+            }
+        }
+
+        // Number of values kept so far
+        int count() const {
+            return int(heap.size());
+        }
+
+        // Write the kept values to out in descending order and return how many there are
+        int result(int out[]) const {
+            int n = count();
+            std::copy(heap.begin(), heap.end(), out);
+            heapSort(out, n, lessThan);
+            return n;
+        }
+
+    private:
+        int k;
+        pmr::vector<int> heap; // Min-heap, heap[0] is the smallest kept value
+    };
+//--------------------------------------------------------->
+
+private:
+    // Every heap comparison goes through these, so they do the counting
+    static bool lessThan(int a, int b) {
+        Instrumentation::count(Operation::Comparison);
+        return a < b;
+    }
+    static bool greaterThan(int a, int b) {
+        Instrumentation::count(Operation::Comparison);
+        return a > b;
+    }
+
+    // Heap helpers; before(a, b) means a belongs above b (greaterThan = max-heap)
+    static void siftDown(int heap[], int size, int pos, bool (*before)(int, int)) {
+        while (true) {
+            int child = 2 * pos + 1;
+            if (child >= size) return;
+            if (child + 1 < size && before(heap[child + 1], heap[child])) child++;
+            if (!before(heap[child], heap[pos])) return;
+            Helper::swap(heap, pos, child);
+            pos = child;
+        }
+    }
+
+    static void siftUp(int heap[], int pos, bool (*before)(int, int)) {
+        while (pos > 0) {
+            int parent = (pos - 1) / 2;
+            if (!before(heap[pos], heap[parent])) return;
+            Helper::swap(heap, pos, parent);
+            pos = parent;
+        }
+    }
+
+    // Sort a heap in place: a max-heap ends ascending, a min-heap descending
+    static void heapSort(int heap[], int size, bool (*before)(int, int)) {
+        for (int end = size - 1; end > 0; end--) {
+            Helper::swap(heap, 0, end);
+            siftDown(heap, end, 0, before);
+        }
+    }
+
+    // Partition with the same kernel quickSortHelper uses (pivot = arr[high])
+    static int partition(int arr[], int low, int high) {
+        if (high - low >= 32 && VectorizedPartition::available()) {
+            return VectorizedPartition::partition<Instrumentation>(arr, low, high);
+        }
+        return Sorting::partition(arr, low, high);
+    }
+
+    // Find the k-th smallest in arr[low..high]. Once two partition steps have
+    // left more than 3/4 of their range, switch to median-of-medians pivots
+    // for the rest of the search.
+    static void select(int arr[], int low, int high, int k, bool guaranteed) {
+        int badSteps = 0;
+        while (high - low >= SortingNetworks::maxNetworkSize) {
+            int before = high - low + 1;
+            if (guaranteed) {
+                medianOfMediansToHigh(arr, low, high);
+            } else {
+                medianOfThreeToHigh(arr, low, high);
+            }
+
+            int pi = partition(arr, low, high);
+            // Collect keys equal to the pivot next to it so duplicates can't stall progress
+            int equalLow = pi;
+            Instrumentation::count(Operation::Comparison, pi - low);
+            for (int i = pi - 1; i >= low; i--) {
+                if (arr[i] == arr[pi]) Helper::swap(arr, i, --equalLow);
+            }
+
+            if (k >= equalLow && k <= pi) return;
+            if (k < equalLow) {
+                high = equalLow - 1;
+            } else {
+                low = pi + 1;
+            }
+
+            if (!guaranteed && (high - low + 1) * 4 > before * 3 && ++badSteps > 1) {
+                guaranteed = true;
+            }
+        }
+        SortingNetworks::sortSmall<Instrumentation>(arr + low, high - low + 1);
+    }
+
+    static void medianOfThreeToHigh(int arr[], int low, int high) {
+        int mid = low + (high - low) / 2;
+        Instrumentation::count(Operation::Comparison, 3);
+        if (arr[mid] < arr[low]) Helper::swap(arr, mid, low);
+        if (arr[high] < arr[low]) Helper::swap(arr, high, low);
+        if (arr[mid] < arr[high]) Helper::swap(arr, mid, high);
+    }
+
+    // Move the median of the group-of-5 medians to arr[high]
+    static void medianOfMediansToHigh(int arr[], int low, int high) {
+        int groups = 0;
+        for (int first = low; first <= high; first += 5) {
+            int count = std::min(5, high - first + 1);
+            Sorting::insertionSort(arr + first, count);
+            Helper::swap(arr, low + groups, first + count / 2);
+            groups++;
+        }
+        select(arr, low, low + groups - 1, low + groups / 2, true);
+        Helper::swap(arr, low + groups / 2, high);
+    }
+};
+
+using SelectionAlgorithms = BasicSelectionAlgorithms<>;
+
+// Thread pool where each worker owns a deque of tasks: it pushes and pops
+// its own work at the back, and when it runs dry steals from the front of
+// another worker's deque. Tasks may submit more tasks. The thread that calls
+// wait() works as worker 0 until every task is done. A thread that finds no
+// task spins briefly and then sleeps until a task is queued, so an idle pool
+// holds no cores.
+class WorkStealingPool {
+public:
+    static constexpr int idleSpins = 64; // Failed task searches before a thread sleeps
+
+    explicit WorkStealingPool(int threads)
+        : queues(std::max(threads, 1)), pending(0), queued(0), sleeping(0), stop(false) {
+        for (auto& queue : queues) queue = make_unique<TaskQueue>();
+        for (int i = 1; i < int(queues.size()); i++) {
+            workers.emplace_back([this, i] {
+                bind(i);
+                int idle = 0;
+                while (!stop.load(memory_order_acquire)) {
+                    if (runOne(i)) {
+                        idle = 0;
+                    } else if (++idle < idleSpins) {
+                        this_thread::yield();
+                    } else {
+                        sleepUntil([this] { return stop.load() || queued.load() > 0; });
+                        idle = 0;
+                    }
+                }
+            });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> lock(idleLock);
+            stop.store(true);
+        }
+        wakeUp.notify_all();
+        for (thread& worker : workers) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queue a task on the calling worker's deque (worker 0 from outside the pool)
+    void submit(function<void()> task) {
+        int self = currentPool == this ? currentIndex : 0;
+        pending.fetch_add(1, memory_order_relaxed);
+        {
+            lock_guard<mutex> lock(queues[self]->lock);
+            queues[self]->tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1);
+        notifySleepers(false);
+    }
+
+    // Run tasks on the calling thread until all submitted work has finished
+    void wait() {
+        bind(0);
+        int idle = 0;
+        while (pending.load(memory_order_acquire) > 0) {
+            if (runOne(0)) {
+                idle = 0;
+            } else if (++idle < idleSpins) {
+                this_thread::yield();
+            } else {
+                sleepUntil([this] { return pending.load() == 0 || queued.load() > 0; });
+                idle = 0;
+            }
+        }
+    }
+
+    // Run one queued task on the calling thread; lets a task that waits on
+    // its own subtasks help with them instead of blocking
+    bool helpOne() {
+        return runOne(currentPool == this ? currentIndex : 0);
+    }
+
+    int size() const {
+        return int(queues.size());
+    }
+
+private:
+    struct TaskQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<TaskQueue>> queues;
+    vector<thread> workers;
+    atomic<long> pending;  // Submitted tasks that have not finished yet
+    atomic<long> queued;   // Submitted tasks that no thread has taken yet
+    atomic<int> sleeping;  // Threads blocked in sleepUntil
+    atomic<bool> stop;
+    mutex idleLock;
+    condition_variable wakeUp;
+
+    static inline thread_local WorkStealingPool* currentPool = nullptr;
+    static inline thread_local int currentIndex = 0;
+
+    void bind(int index) {
+        currentPool = this;
+        currentIndex = index;
+    }
+
+    // Block until ready() holds. A sleeper announces itself before checking,
+    // and a waker changes the state before looking for sleepers (both
+    // sequentially consistent), so a wake-up can't slip between the two.
+    template <class Ready>
+    void sleepUntil(Ready ready) {
+        unique_lock<mutex> lock(idleLock);
+        sleeping.fetch_add(1);
+        wakeUp.wait(lock, ready);
+        sleeping.fetch_sub(1);
+    }
+
+    void notifySleepers(bool all) {
+        if (sleeping.load() == 0) return;
+        lock_guard<mutex> lock(idleLock); // A sleeper is either waiting or hasn't checked yet
+        if (all) {
+            wakeUp.notify_all();
+        } else {
+            wakeUp.notify_one();
+        }
+    }
+
+    // Run one task from our own deque, or steal one; false if none was found
+    bool runOne(int self) {
+        function<void()> task;
+        int n = int(queues.size());
+        for (int i = 0; i < n && !task; i++) {
+            TaskQueue& queue = *queues[(self + i) % n];
+            lock_guard<mutex> lock(queue.lock);
+            if (queue.tasks.empty()) continue;
+            if (i == 0) {
+                task = std::move(queue.tasks.back()); // Newest own task: still warm in cache
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front()); // Oldest task of a victim: the biggest piece
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task) return false;
+        queued.fetch_sub(1);
+        task();
+        if (pending.fetch_sub(1, memory_order_acq_rel) == 1) {
+            notifySleepers(true); // Wakes wait() once the last task is done
+        }
+        return true;
+    }
+};
+
+// Parallel sample sort for large int arrays. Each level draws an oversampled
+// set of splitters, classifies every element with a branch-free walk down an
+// implicit (Eytzinger) search tree, scatters elements into up to 256 buckets in
+// parallel (per-stripe counts + prefix sums), and then sorts the buckets as
+// independent tasks on a work-stealing pool, recursing on buckets that are
+// still large. Uses one scratch buffer of n ints plus n bytes of bucket ids.
+class ParallelSort {
+public:
+    static constexpr size_t sequentialThreshold = size_t(1) << 16; // Leaves are sorted by a single task
+    static constexpr int maxLogBuckets = 8;
+    static constexpr int oversampling = 16;                   // Samples per bucket
+
+    // threads = 0 uses one thread per hardware thread. That default runs on
+    // one pool kept for the whole program, whose workers sleep between calls;
+    // any other thread count gets a pool of its own for the call.
+    static void sampleSort(int arr[], size_t size, int threads = 0) {
+        int hardwareThreads = int(std::max(1u, thread::hardware_concurrency()));
+        if (threads <= 0) threads = hardwareThreads;
+        if (size <= sequentialThreshold || threads == 1) {
+            SortingAlgorithms::mergeSort(span<int>(arr, size)); // Radix sort for ints
+            return;
+        }
+        if (threads == hardwareThreads) {
+            static WorkStealingPool sharedPool(hardwareThreads);
+            sortOn(sharedPool, arr, size);
+        } else {
+            WorkStealingPool pool(threads);
+            sortOn(pool, arr, size);
+        }
+    }
+
+private:
+    struct Context {
+        WorkStealingPool& pool;
+        int* data;        // Array being sorted
+        int* buffer;      // Scratch space, same size as data
+        uint8_t* bucketOf; // Bucket id of each element during classification
+    };
+
+    static void sortOn(WorkStealingPool& pool, int arr[], size_t size) {
+        vector<int> buffer(size);
+        vector<uint8_t> bucketOf(size);
+        Context context{ pool, arr, buffer.data(), bucketOf.data() };
+        pool.submit([&context, size] { sortRange(context, 0, size); });
+        pool.wait();
+    }
+
+    // Radix sort arr in place, with scratch (size elements) as its buffer
+    static void sortSequential(int arr[], size_t size, int scratch[]) {
+        SortingAlgorithms::radixSort(span<int>(arr, size), span<int>(scratch, size));
+    }
+
+    // Sort data[begin, begin + size) using the same range of the scratch arrays
+    static void sortRange(Context& context, size_t begin, size_t size) {
+        int* data = context.data + begin;
+        int* buffer = context.buffer + begin;
+        if (size <= sequentialThreshold) {
+            sortSequential(data, size, buffer);
+            return;
+        }
+        uint8_t* bucketOf = context.bucketOf + begin;
+
+        // Pick splitters from a sorted random sample
+        int logBuckets = std::min<int>(maxLogBuckets, bit_width(size / sequentialThreshold) + 1);
+        int buckets = 1 << logBuckets;
+        vector<int> sample(size_t(buckets) * oversampling);
+        uint64_t state = begin * 0x9E3779B97F4A7C15ull + size;
+        for (int& s : sample) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            s = data[multiplyHigh(state, size)];
+        }
+        SortingAlgorithms::mergeSort(span<int>(sample));
+        if (sample.front() == sample.back()) {
+            // Sample is one repeated key: almost certainly no split worth a level
+            sortSequential(data, size, buffer);
+            return;
+        }
+
+        // Splitters in Eytzinger order: children of node j are 2j and 2j+1
+        vector<int> tree(buckets);
+        int next = 0;
+        function<void(int)> place = [&](int node) {
+            if (node >= buckets) return;
+            place(2 * node);
+            tree[node] = sample[size_t(++next) * oversampling - 1];
+            place(2 * node + 1);
+        };
+        place(1);
+
+        // Classify stripes in parallel, counting bucket sizes per stripe
+        int stripes = std::min<int>(context.pool.size() * 4, int(size / 4096) + 1);
+        vector<size_t> counts(size_t(stripes) * buckets, 0);
+        parallelStripes(context.pool, size, stripes, [&](int stripe, size_t first, size_t last) {
+            size_t* count = &counts[size_t(stripe) * buckets];
+            for (size_t i = first; i < last; i++) {
+                int x = data[i];
+                unsigned j = 1;
+                for (int level = 0; level < logBuckets; level++) {
+                    j = 2 * j + unsigned(x > tree[j]); // No branch on the comparison
+                }
+                bucketOf[i] = uint8_t(j - buckets);
+                count[j - buckets]++;
+            }
+        });
+
+        // Bucket-major prefix sums give each stripe its write offset in each bucket
+        vector<size_t> bucketStart(buckets + 1, 0);
+        size_t offset = 0;
+        for (int b = 0; b < buckets; b++) {
+            bucketStart[b] = offset;
+            for (int stripe = 0; stripe < stripes; stripe++) {
+                size_t c = counts[size_t(stripe) * buckets + b];
+                counts[size_t(stripe) * buckets + b] = offset;
+                offset += c;
+            }
+        }
+        bucketStart[buckets] = size;
+
+        // Scatter into the buffer, then copy the buckets back
+        parallelStripes(context.pool, size, stripes, [&](int stripe, size_t first, size_t last) {
+            size_t* position = &counts[size_t(stripe) * buckets];
+            for (size_t i = first; i < last; i++) {
+                buffer[position[bucketOf[i]]++] = data[i];
+            }
+        });
+        parallelStripes(context.pool, size, stripes, [&](int, size_t first, size_t last) {
+            memcpy(data + first, buffer + first, (last - first) * sizeof(int));
+        });
+
+        for (int b = 0; b < buckets; b++) {
+            size_t bucketSize = bucketStart[b + 1] - bucketStart[b];
+            if (bucketSize < 2) continue;
+            size_t bucketBegin = begin + bucketStart[b];
+            if (bucketSize == size) {
+                sortSequential(data, size, buffer); // No progress (heavy duplicates): finish here
+                return;
+            }
+            Context* shared = &context;
+            context.pool.submit([shared, bucketBegin, bucketSize] { sortRange(*shared, bucketBegin, bucketSize); });
+        }
+    }
+
+    // Run body(stripe, first, last) over equal stripes of [0, size) and wait for all of them
+    template <class Body>
+    static void parallelStripes(WorkStealingPool& pool, size_t size, int stripes, Body body) {
+        atomic<int> remaining(stripes);
+        for (int stripe = 1; stripe < stripes; stripe++) {
+            pool.submit([&, stripe] {
+                body(stripe, size * stripe / stripes, size * (stripe + 1) / stripes);
+                remaining.fetch_sub(1, memory_order_release);
+            });
+        }
+        body(0, 0, size / stripes);
+        remaining.fetch_sub(1, memory_order_release);
+        // Help out instead of blocking until the other stripes are done
+        while (remaining.load(memory_order_acquire) > 0) {
+            if (!pool.helpOne()) this_thread::yield();
+        }
+    }
+};
+
+template <class Instrumentation>
+inline void BasicSortingAlgorithms<Instrumentation>::sort(int arr[], int size, pmr::memory_resource* resource) {
+    if (size < 2) return;
+    const char* engine;
+
+    // One branch-free pass for the exact run count and value range
+    int descents = 0;
+    int minValue = arr[0], maxValue = arr[0];
+    Instrumentation::count(Operation::Comparison, size - 1);
+    for (int i = 1; i < size; i++) {
+        descents += arr[i - 1] > arr[i];
+        minValue = std::min(minValue, arr[i]);
+        maxValue = std::max(maxValue, arr[i]);
+    }
+    int64_t range = int64_t(maxValue) - minValue + 1;
+
+    // Estimate the share of distinct keys from a small evenly spaced sample
+    int sampleSize = std::min(size, adaptiveSampleSize);
+    int sample[adaptiveSampleSize];
+    for (int i = 0; i < sampleSize; i++) {
+        sample[i] = arr[int64_t(i) * size / sampleSize];
+    }
+    mergeSort(span<int>(sample, sampleSize), {}, {}, resource);
+    int distinct = 1;
+    for (int i = 1; i < sampleSize; i++) {
+        distinct += sample[i] != sample[i - 1];
+    }
+    double distinctRatio = double(distinct) / sampleSize;
+
+    if (size <= SortingNetworks::maxNetworkSize) {
+        engine = "sortingNetwork";
+        SortingNetworks::sortSmall<Instrumentation>(arr, size);
+    } else if (descents == 0) {
+        engine = "alreadySorted";
+    } else if (descents == size - 1) {
+        engine = "reverse";
+        std::reverse(arr, arr + size);
+    } else if (descents < adaptiveMaxMergeRuns) {
+        engine = "mergeRuns";
+        mergeRuns(arr, size, resource);
+    } else if (descents <= size / 32 && boundedInsertionSort(arr, size, 8L * size)) {
+        engine = "insertionSort";
+    } else if (range <= size) {
+        engine = "countingSort";
+        countingSort(arr, size, minValue, maxValue, resource);
+    } else if (distinctRatio < 0.5) {
+        engine = "quickSort3Way";
+        quickSort3Way(arr, size);
+    } else if (size >= adaptiveParallelMin && thread::hardware_concurrency() > 1) {
+        engine = "parallelSampleSort";
+        ParallelSort::sampleSort(arr, size_t(size));
+    } else {
+        engine = "introSort";
+        introSortHelper(arr, 0, size - 1, 2 * bit_width(unsigned(size)), resource);
+    }
 
+    if (decisionLog != nullptr) {
+        *decisionLog << "[sort] n=" << size << " runs=" << descents + 1
+                     << " range=[" << minValue << ", " << maxValue << "]"
+                     << " distinct~" << int(distinctRatio * 100) << "% -> " << engine << endl;
+    }
+}
 
-//--------------------------------------------------------------------------------------->
+// Settings for ExternalSort
+struct ExternalSortConfig {
+    size_t memoryBudget = size_t(256) << 20; // Bytes of data buffers the sort may hold at once
+    size_t ioBlockBytes = size_t(8) << 20;   // Largest single read/write issued while merging
+    string tempDirectory;                    // Where sorted runs go ("" = system temp directory)
 };
 
-// Search algorithms
-class SearchAlgorithms {
+// External-memory sort for files of native-endian binary ints that don't fit in RAM.
+// Each phase hands its reads and writes to one long-lived I/O thread.
+// Phase 1 reads the input in runs that fit in the budget, sorts each run in memory
+// (reading the next run while the current one sorts) and writes it to a temp file.
+// Phase 2 merges the runs with a loser tree; every run and the output are
+// double-buffered, so the next block is read (or the previous block written)
+// on the I/O thread while the merge works on the current block. If
+// there are more runs than the budget allows blocks for, runs are merged in
+// several passes. A read or write error anywhere makes sortFile return false.
+class ExternalSort {
 public:
-  static int binarySearch(int arr[], int size, int target) {
-      int left = 0,right = size - 1;  // Initialize right to last index
-
-      while (left <= right) {  // KEY DIFFERENCE 1: Uses <= to ensure all elements are checked
-          // KEY DIFFERENCE 2: Simple mid calculation is fine since overflow is rare in practice
-          int mid = (left + right) / 2;
-          if (arr[mid] == target) {
-              return mid;
-          }else if (arr[mid] > target) {
-              right = mid - 1;  // KEY DIFFERENCE 3: Properly reduces right boundary
-          }else {
-              left = mid + 1;
-          }
-      }
-      return -1;  // KEY DIFFERENCE 4: Always returns -1 if target not found
-  }
-  //--------------------------------------------------------->
-
-  // Defective Binary Search Implementation (with fixes commented)
-  static int defectiveBinarySearch(int arr[], int size, int target) {
-      int left = 0, right = size - 1;
+    static const size_t minBlockBytes = size_t(64) << 10; // Smallest merge block worth a seek
 
-      // DEFECT 1: Uses < instead of <=, which can miss checking the last element
-      while (left < right ) {  // Should be: while (left <= right)
-          // More robust mid calculation to prevent integer overflow
-          int mid = left + (right - left) / 2;
-          if (arr[mid] == target) {
-              return mid;
-          }else if (arr[mid] < target){
-                left = mid;
-          }else {
-              right = mid;                            // DEFECT 2: Doesn't decrease right boundary properly
-          }                                          // Should be: right = mid - 1
-      }
+    static bool sortFile(const string& inputPath, const string& outputPath,
+                         const ExternalSortConfig& config = ExternalSortConfig()) {
+        if (config.memoryBudget < 4 * minBlockBytes) {
+            cerr << "External sort needs a memory budget of at least " << 4 * minBlockBytes << " bytes." << endl;
+            return false;
+        }
+        error_code ec;
+        filesystem::path tempDir = config.tempDirectory.empty() ? filesystem::temp_directory_path(ec)
+                                                                : filesystem::path(config.tempDirectory);
+        if (ec) {
+            cerr << "No temp directory for external sort: " << ec.message() << endl;
+            return false;
+        }
 
-    cout << "Not Found" << endl;
-  }
+        vector<string> runs;
+        bool ok = formRuns(inputPath, outputPath, tempDir, config, runs);
+        if (ok && runs.empty()) {
+            IoWorker io;
+            ok = BlockWriter(outputPath, 1, io).close(); // Empty input gives an empty output
+        } else if (ok && runs.size() == 1 && (filesystem::rename(runs[0], outputPath, ec), !ec)) {
+            runs.clear(); // A single run is already the answer
+        } else if (ok) {
+            ok = mergeAll(runs, outputPath, tempDir, config);
+        }
+        for (const string& run : runs) {
+            filesystem::remove(run, ec);
+        }
+        return ok;
+    }
 
-  //--------------------------------------------------------->
+private:
+    // One long-lived thread that runs reads and writes in the order they were
+    // submitted, instead of starting a thread per run or block
+    class IoWorker {
+    public:
+        IoWorker() : stopping(false), worker([this] { run(); }) {}
 
-    // Linear Search: Iterative
-  static int linearSearch(int arr[], int size, int target) {
-      for (int i = 0; i < size; i++) {
-          if (arr[i] == target) {
-              return i;  // Return the index of the target
-          }
-      }
-      return -1;  // Return -1 if target not found
-  }
-  //--------------------------------------------------------->
+        ~IoWorker() {
+            {
+                lock_guard<mutex> lock(queueLock);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
 
-  // Linear Search: Recursive
-  static int recursiveLinearSearch(int arr[], int size, int target, int index = 0) {
-      if (index >= size) {
-          return -1;  // Base case: target not found
-      }
-      if (arr[index] == target) {
-          return index;  // Base case: target found
-      }
-      return recursiveLinearSearch(arr, size, target, index + 1);  // Recursive case
-  }
-};
+        IoWorker(const IoWorker&) = delete;
+        IoWorker& operator=(const IoWorker&) = delete;
 
-// Sorting algorithms
-class SortingAlgorithms {
-public:
-    static void bubbleSort(int arr[], int size) {
-        bool swapped;
-        for (int i = 0; i < size - 1; i++) {
-            swapped = false;
-            for (int j = 0; j < size - i - 1; j++) {
-                if (arr[j] > arr[j + 1]) {
-                    ArrayHelper::swap(arr, j, j + 1);
-                    swapped = true;
-                }
-            }
-            if (!swapped) {
-                break;
+        template <class Job>
+        future<invoke_result_t<Job>> submit(Job job) {
+            auto task = make_shared<packaged_task<invoke_result_t<Job>()>>(std::move(job));
+            auto result = task->get_future();
+            {
+                lock_guard<mutex> lock(queueLock);
+                jobs.push_back([task] { (*task)(); });
             }
+            wake.notify_one();
+            return result;
         }
-    }
-//--------------------------------------------------------->
 
-    static void selectionSort(int arr[], int size) {
-        for (int i = 0; i < size - 1; i++) {
-            int min_idx = i;
-            for (int j = i + 1; j < size; j++) {
-                if (arr[j] < arr[min_idx]) {
-                    min_idx = j;
-                }
-            }
-            if (min_idx != i) {
-                ArrayHelper::swap(arr, i, min_idx);
+    private:
+        mutex queueLock;
+        condition_variable wake;
+        deque<function<void()>> jobs;
+        bool stopping;
+        thread worker;
+
+        // Run jobs until stopped and the queue has drained
+        void run() {
+            unique_lock<mutex> lock(queueLock);
+            while (true) {
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                function<void()> job = std::move(jobs.front());
+                jobs.pop_front();
+                lock.unlock();
+                job();
+                lock.lock();
             }
         }
-    }
-//--------------------------------------------------------->
+    };
 
-    static void insertionSort(int arr[], int size) {
-        for (int i = 1; i < size; i++) {
-            int key = arr[i];
-            int j = i - 1;
-            while (j >= 0 && arr[j] > key) {
-                arr[j + 1] = arr[j];
-                j--;
+    // Reads one file block by block; the next block loads on the I/O thread.
+    // A failed read ends the run early and is reported by failed().
+    class BlockReader {
+    public:
+        BlockReader(const string& path, size_t blockElements, IoWorker& io)
+            : io(io), file(fopen(path.c_str(), "rb")), current(blockElements), next(blockElements),
+              pos(0), count(0), readFailed(false) {
+            if (file == nullptr) return;
+            count = readBlock(current);
+            prefetch();
+        }
+
+        ~BlockReader() {
+            if (pending.valid()) pending.wait();
+            if (file != nullptr) fclose(file);
+        }
+
+        bool isOpen() const { return file != nullptr; }
+        bool failed() const { return readFailed.load(); }
+        bool exhausted() const { return pos == count; }
+        int peek() const { return current[pos]; }
+
+        void pop() {
+            if (++pos == count) {
+                count = pending.valid() ? pending.get() : 0;
+                swap(current, next);
+                pos = 0;
+                if (count > 0) prefetch();
             }
-            arr[j + 1] = key;
         }
-    }
-//--------------------------------------------------------->
 
-    static void merge(int arr[], int left, int mid, int right) {
-        int n1 = mid - left + 1;
-        int n2 = right - mid;
+    private:
+        IoWorker& io;
+        FILE* file;
+        vector<int> current, next; // Block being merged and block being loaded
+        size_t pos, count;
+        atomic<bool> readFailed;   // Set on the I/O thread
+        future<size_t> pending;
+
+        size_t readBlock(vector<int>& block) {
+            size_t n = fread(block.data(), sizeof(int), block.size(), file);
+            if (ferror(file)) readFailed = true;
+            return n;
+        }
 
-        // Create temporary arrays
-        int* L = new int[n1];
-        int* R = new int[n2];
+        void prefetch() {
+            pending = io.submit([this] { return readBlock(next); });
+        }
+    };
 
-        // Copy data to temporary arrays
-        for (int i = 0; i < n1; i++)
-            L[i] = arr[left + i];
-        for (int j = 0; j < n2; j++)
-            R[j] = arr[mid + 1 + j];
+    // Collects output into blocks; a full block is written on the I/O thread
+    class BlockWriter {
+    public:
+        BlockWriter(const string& path, size_t blockElements, IoWorker& io)
+            : io(io), file(fopen(path.c_str(), "wb")), current(blockElements), spare(blockElements), count(0), failed(false) {}
 
-        // Merge the temporary arrays back into arr
-        int i = 0, j = 0, k = left;
-        while (i < n1 && j < n2) {
-            if (L[i] <= R[j]) {
-                arr[k] = L[i];
-                i++;
-            } else {
-                arr[k] = R[j];
-                j++;
-            }
-            k++;
+        ~BlockWriter() { close(); }
+
+        bool isOpen() const { return file != nullptr; }
+
+        void push(int value) {
+            current[count++] = value;
+            if (count == current.size()) flush();
         }
 
-        // Copy remaining elements of L[]
-        while (i < n1) {
-            arr[k] = L[i];
-            i++;
-            k++;
+        // Write what is left and report whether every write succeeded
+        bool close() {
+            if (file == nullptr) return false;
+            flush();
+            if (pending.valid()) failed |= !pending.get();
+            failed |= fclose(file) != 0;
+            file = nullptr;
+            return !failed;
         }
 
-        // Copy remaining elements of R[]
-        while (j < n2) {
-            arr[k] = R[j];
-            j++;
-            k++;
+    private:
+        IoWorker& io;
+        FILE* file;
+        vector<int> current, spare; // Block being filled and block being written
+        size_t count;
+        bool failed;
+        future<bool> pending;
+
+        void flush() {
+            if (count == 0) return;
+            if (pending.valid()) failed |= !pending.get();
+            swap(current, spare);
+            size_t toWrite = count;
+            count = 0;
+            pending = io.submit([this, toWrite] {
+                return fwrite(spare.data(), sizeof(int), toWrite, file) == toWrite;
+            });
         }
+    };
 
-        // Free temporary arrays
-        delete[] L;
-        delete[] R;
-    }
+    // Tournament tree over k sources: tree[0] holds the source with the smallest
+    // key and tree[1..k-1] the loser of each match, so replacing the winner
+    // replays only the log2(k) matches on its path to the root.
+    class LoserTree {
+    public:
+        explicit LoserTree(vector<BlockReader*>& sources) : sources(sources), k(int(sources.size())), tree(k, k) {
+            // Source k is a virtual -infinity; it is pushed out as the real sources enter
+            for (int i = k - 1; i >= 0; i--) replay(i);
+        }
 
-    static void mergeSortHelper(int arr[], int left, int right) {
-        if (left < right) {
-            int mid = left + (right - left) / 2;
-            mergeSortHelper(arr, left, mid);
-            mergeSortHelper(arr, mid + 1, right);
-            merge(arr, left, mid, right);
+        // Source holding the smallest current key, or -1 when all are exhausted
+        int winner() const {
+            return sources[tree[0]]->exhausted() ? -1 : tree[0];
         }
-    }
 
-    static void mergeSort(int arr[], int size) {
-        mergeSortHelper(arr, 0, size - 1);
+        // Call after the winner's source has advanced
+        void replay(int source) {
+            for (int t = (source + k) / 2; t > 0; t /= 2) {
+                if (beats(tree[t], source)) swap(tree[t], source);
+            }
+            tree[0] = source;
+        }
+
+    private:
+        vector<BlockReader*>& sources;
+        int k;
+        vector<int> tree;
+
+        bool beats(int a, int b) const {
+            if (a == k || b == k) return a == k;
+            if (sources[a]->exhausted()) return false;
+            if (sources[b]->exhausted()) return true;
+            return sources[a]->peek() < sources[b]->peek();
+        }
+    };
+
+    static string runPath(const filesystem::path& tempDir, const string& outputPath, size_t index) {
+        static atomic<unsigned> sortId{0};
+        static const unsigned session = unsigned(hash<string>{}(outputPath) ^ uint64_t(time(nullptr)));
+        return (tempDir / ("extsort_" + to_string(session) + "_" + to_string(sortId++) + "_" + to_string(index) + ".run")).string();
     }
-//--------------------------------------------------------->
 
-    static int partition(int arr[], int low, int high) {
-        int pivot = arr[high];
-        int i = low - 1;
+    // Phase 1: cut the input into sorted runs
+    static bool formRuns(const string& inputPath, const string& outputPath, const filesystem::path& tempDir,
+                         const ExternalSortConfig& config, vector<string>& runs) {
+        FILE* input = fopen(inputPath.c_str(), "rb");
+        if (input == nullptr) {
+            cerr << "Cannot open " << inputPath << " for reading." << endl;
+            return false;
+        }
+        error_code ec;
+        if (filesystem::file_size(inputPath, ec) % sizeof(int) != 0) {
+            cerr << inputPath << " is not a whole number of ints." << endl;
+            fclose(input);
+            return false;
+        }
 
-        for (int j = low; j < high; j++) {
-            if (arr[j] <= pivot) {
-                i++;
-                ArrayHelper::swap(arr, i, j);
+        // Two run buffers (one loading, one sorting) plus the sort's scratch space
+        size_t runElements = config.memoryBudget / (3 * sizeof(int));
+        vector<int> current(runElements), next(runElements);
+        size_t count = fread(current.data(), sizeof(int), runElements, input);
+        bool ok = true;
+
+        IoWorker io; // Reads the next run while this one is sorted and written
+        while (count > 0) {
+            future<size_t> pending = io.submit([&] {
+                return fread(next.data(), sizeof(int), runElements, input);
+            });
+
+            SortingAlgorithms::mergeSort(span<int>(current.data(), count));
+
+            string path = runPath(tempDir, outputPath, runs.size());
+            runs.push_back(path);
+            FILE* run = fopen(path.c_str(), "wb");
+            if (run == nullptr || fwrite(current.data(), sizeof(int), count, run) != count) {
+                cerr << "Cannot write run file " << path << endl;
+                ok = false;
             }
+            if (run != nullptr && fclose(run) != 0) ok = false;
+
+            count = pending.get();
+            swap(current, next);
+            if (!ok) break;
         }
-        ArrayHelper::swap(arr, i + 1, high);
-        return i + 1;
+
+        if (ok && ferror(input)) {
+            cerr << "Read error on " << inputPath << endl;
+            ok = false;
+        }
+        fclose(input);
+        return ok;
     }
 
-    static void quickSortHelper(int arr[], int low, int high) {
-        if (low < high) {
-            int pi = partition(arr, low, high);
-            quickSortHelper(arr, low, pi - 1);
-            quickSortHelper(arr, pi + 1, high);
+    // Phase 2: merge runs, in several passes if there are too many for the budget
+    static bool mergeAll(vector<string>& runs, const string& outputPath, const filesystem::path& tempDir,
+                         const ExternalSortConfig& config) {
+        // Every input and the output get two blocks each
+        size_t maxFanIn = max<size_t>(2, (config.memoryBudget / minBlockBytes - 2) / 2);
+        error_code ec;
+
+        while (runs.size() > maxFanIn) {
+            vector<string> merged;
+            for (size_t first = 0; first < runs.size(); first += maxFanIn) {
+                size_t last = min(runs.size(), first + maxFanIn);
+                vector<string> group(runs.begin() + first, runs.begin() + last);
+                string path = runPath(tempDir, outputPath, runs.size() + merged.size());
+                merged.push_back(path);
+                bool ok = mergeRuns(group, path, config);
+                for (const string& run : group) filesystem::remove(run, ec);
+                if (!ok) {
+                    runs.assign(runs.begin() + last, runs.end());
+                    runs.insert(runs.end(), merged.begin(), merged.end());
+                    return false;
+                }
+            }
+            runs = merged;
         }
+        return mergeRuns(runs, outputPath, config);
     }
 
-    static void quickSort(int arr[], int size) {
-        quickSortHelper(arr, 0, size - 1);
+    static bool mergeRuns(const vector<string>& runs, const string& outputPath, const ExternalSortConfig& config) {
+        size_t blockBytes = min(config.ioBlockBytes, config.memoryBudget / (2 * runs.size() + 2));
+        size_t blockElements = max<size_t>(1, blockBytes / sizeof(int));
+
+        IoWorker io; // Declared first so it outlives every reader and the writer
+        vector<unique_ptr<BlockReader>> readers;
+        vector<BlockReader*> sources;
+        for (const string& run : runs) {
+            readers.push_back(make_unique<BlockReader>(run, blockElements, io));
+            if (!readers.back()->isOpen()) {
+                cerr << "Cannot open run file " << run << endl;
+                return false;
+            }
+            sources.push_back(readers.back().get());
+        }
+        BlockWriter output(outputPath, blockElements, io);
+        if (!output.isOpen()) {
+            cerr << "Cannot open " << outputPath << " for writing." << endl;
+            return false;
+        }
+
+        LoserTree tree(sources);
+        for (int source = tree.winner(); source != -1; source = tree.winner()) {
+            output.push(sources[source]->peek());
+            sources[source]->pop();
+            tree.replay(source);
+        }
+        for (size_t i = 0; i < readers.size(); i++) {
+            if (readers[i]->failed()) {
+                cerr << "Read error on run file " << runs[i] << endl;
+                output.close();
+                return false;
+            }
+        }
+        if (!output.close()) {
+            cerr << "Write error on " << outputPath << endl;
+            return false;
+        }
+        return true;
     }
-  //--------------------------------------------------------->
 };
 
 
@@ -881,8 +4456,27 @@ int main() {
   cout << "Randomly generated array: ";
   ArrayHelper::printArray(randomArray, size);
 
-  // Sort the array
-  SortingAlgorithms::bubbleSort(randomArray, size);
+  // Other input shapes from the same generator (same seed, same output on any thread count)
+  GeneratorOptions options;
+  options.minimum_num = minimum_num;
+  options.maximum_num = maximum_num;
+  options.seed = 42;
+  options.disorder = 0.2;
+  options.uniqueValues = 3;
+  const pair<Distribution, const char*> shapes[] = {
+      {Distribution::Zipf, "Zipf"}, {Distribution::NearlySorted, "Nearly sorted"},
+      {Distribution::FewUnique, "Few unique"}, {Distribution::Adversarial, "Quicksort killer"}};
+  for (const auto& shape : shapes) {
+    options.distribution = shape.first;
+    AlignedBuffer<int> sample = DataGenerator::generate(size, options);
+    cout << shape.second << " array: ";
+    ArrayHelper::printArray(sample.data(), size);
+  }
+
+  // Sort the array, letting the adaptive dispatcher explain its choice
+  SortingAlgorithms::setDecisionLog(&cout);
+  SortingAlgorithms::sort(randomArray, size);
+  SortingAlgorithms::setDecisionLog(nullptr);
 
   cout << "Sorted random array: ";
   ArrayHelper::printArray(randomArray, size);
@@ -914,6 +4508,24 @@ int main() {
 
   separate();
 
+  // Order statistics without a full sort
+  int* statsArray = ArrayHelper::generateRandomArray(size, minimum_num, maximum_num);
+  cout << "Array for selection: ";
+  ArrayHelper::printArray(statsArray, size);
+
+  int topValues[3];
+  int topCount = SelectionAlgorithms::topK(statsArray, size, 3, topValues);
+  cout << "Top 3 values: ";
+  ArrayHelper::printArray(topValues, topCount);
+
+  cout << "Median: " << SelectionAlgorithms::median(statsArray, size) << endl;
+  SelectionAlgorithms::partialSort(statsArray, size, 5);
+  cout << "5 smallest values: ";
+  ArrayHelper::printArray(statsArray, 5);
+  delete[] statsArray;
+
+  separate();
+
   // Demonstrate LinkedList
   LinkedList list;
   cout << "Adding elements to linked list..." << endl;
@@ -929,6 +4541,44 @@ int main() {
   cout << "Updated linked list: ";
   list.print();
 
+  // Sort and merge linked lists in place
+  LinkedList unsortedList;
+  for (int i = 0; i < size; i += 2) {
+    unsortedList.insertAtStart(randomArray[i]);
+  }
+  cout << "Unsorted linked list: ";
+  unsortedList.print();
+  unsortedList.sort();
+  cout << "Sorted linked list: ";
+  unsortedList.print();
+
+  list.mergeSorted(unsortedList);
+  cout << "Merged linked list: ";
+  list.print();
+  list.sortUnique();
+  cout << "Unique values: ";
+  list.print();
+
+  separate();
+
+  // Demonstrate IndexedSkipList
+  IndexedSkipList skipList;
+  cout << "Adding elements to indexed skip list..." << endl;
+  for (int i = 0; i < size; i++) {
+    skipList.insert(randomArray[i]);
+  }
+  cout << "Skip list contents: ";
+  skipList.print();
+
+  cout << "Element at position 5: " << skipList.at(5) << endl;
+  cout << "Position of " << randomArray[7] << ": " << skipList.find(randomArray[7]) << endl;
+
+  cout << "Removing " << randomArray[2] << " and the element at position 0 from skip list." << endl;
+  skipList.removeKey(randomArray[2]);
+  skipList.removeAtPosition(0);
+  cout << "Updated skip list: ";
+  skipList.print();
+
   separate();
 
   // Cleanup
@@ -1007,5 +4657,216 @@ int main() {
     cout << "Hash Table Contents: " << endl;
     PersonTable.dump();
 
+  separate();
+
+    // Generic sorts: records by a member, 64-bit ids and floating-point values
+    vector<HashTable::PersonData> people;
+    for (const auto& emp : Persons) {
+        people.push_back({ get<1>(emp), get<2>(emp), get<3>(emp) });
+    }
+    SortingAlgorithms::mergeSort(span(people), {}, &HashTable::PersonData::lastName);
+    cout << "People sorted by last name: ";
+    ArrayHelper::printArray(span(people), &HashTable::PersonData::lastName);
+
+    vector<long long> ids = { 9000000000LL, -42, 7, 123456789012LL, 0, -9000000000LL };
+    SortingAlgorithms::mergeSort(span(ids));
+    cout << "Sorted 64-bit ids: ";
+    ArrayHelper::printArray(span(ids));
+    cout << "Index of 7: " << SearchAlgorithms::binarySearch(span(ids), 7LL) << endl;
+
+    vector<double> readings = { 3.5, -1.25, 2.0, -0.5, 10.75 };
+    SortingAlgorithms::quickSort(span(readings), ranges::greater{});
+    cout << "Readings in descending order: ";
+    ArrayHelper::printArray(span(readings));
+
+  separate();
+
+    // External sort: a file several times larger than the memory budget
+    const int fileInts = 1000000;
+    string unsortedFile = (filesystem::temp_directory_path() / "algos_unsorted.bin").string();
+    string sortedFile = (filesystem::temp_directory_path() / "algos_sorted.bin").string();
+    GeneratorOptions fileOptions;
+    fileOptions.maximum_num = 1000000;
+    AlignedBuffer<int> fileData = DataGenerator::generate(fileInts, fileOptions);
+    FILE* dataFile = fopen(unsortedFile.c_str(), "wb");
+    if (dataFile != nullptr) {
+        fwrite(fileData.data(), sizeof(int), fileInts, dataFile);
+        fclose(dataFile);
+    }
+
+    ExternalSortConfig sortConfig;
+    sortConfig.memoryBudget = size_t(1) << 20; // 1 MiB for a 4 MB file
+    if (ExternalSort::sortFile(unsortedFile, sortedFile, sortConfig)) {
+        vector<int> head(10);
+        dataFile = fopen(sortedFile.c_str(), "rb");
+        if (dataFile != nullptr) {
+            size_t headCount = fread(head.data(), sizeof(int), head.size(), dataFile);
+            fclose(dataFile);
+            cout << "External sort of " << fileInts << " ints with a 1 MiB budget, first values: ";
+            ArrayHelper::printArray(head.data(), int(headCount));
+        } else {
+            cerr << "Cannot open " << sortedFile << " for reading." << endl;
+        }
+    }
+    filesystem::remove(unsortedFile);
+    filesystem::remove(sortedFile);
+
+    // Parallel sample sort on the in-memory copy of the same data
+    ParallelSort::sampleSort(fileData.data(), fileData.size());
+    cout << "Parallel sample sort of " << fileData.size() << " ints sorted: "
+         << (is_sorted(fileData.data(), fileData.data() + fileData.size()) ? "yes" : "no") << endl;
+
+  separate();
+
+    // Operation counts: the Basic* templates with OperationCounters report
+    // every comparison, swap, move, allocation and probe they perform
+    using CountedSort = BasicSortingAlgorithms<OperationCounters>;
+    OperationProfiler profiler;
+    GeneratorOptions profileOptions;
+    for (int n : { 1000, 10000 }) {
+        AlignedBuffer<int> input = DataGenerator::generate(n, profileOptions);
+        vector<int> work(input.data(), input.data() + n);
+        profiler.profile("quickSort", [&] { CountedSort::quickSort(work.data(), n); });
+        work.assign(input.data(), input.data() + n);
+        profiler.profile("mergeSort", [&] { CountedSort::mergeSort(work.data(), n); });
+        work.assign(input.data(), input.data() + 1000);
+        profiler.profile("insertionSort", [&] { CountedSort::insertionSort(work.data(), 1000); });
+        profiler.profile("binarySearch", [&] {
+            for (int i = 0; i < n; i += 10) BasicSearchAlgorithms<OperationCounters>::binarySearch(work.data(), 1000, input[i]);
+        });
+    }
+
+    profiler.profile("hashTable", [&] {
+        BasicHashTable<OperationCounters> countedTable;
+        // Keys that all share one home slot, so every insert and lookup walks the cluster
+        for (int id = 0; id < countedTable.getSize() - 3; id++) countedTable.insert(id * countedTable.getSize() + 1, { "Last", "First", "01-01-2024" });
+        BasicHashTable<OperationCounters>::PersonData found;
+        for (int id = 0; id < countedTable.getSize(); id++) countedTable.lookup(id * countedTable.getSize() + 1, found);
+    });
+    profiler.profile("linkedListSort", [&] {
+        BasicLinkedList<OperationCounters> countedList;
+        for (int i = 0; i < 1000; i++) countedList.insertAtEnd(fileData[(i * 7919) % fileInts]);
+        countedList.sort();
+    });
+    profiler.exportJson(cout);
+
+  separate();
+
+    // Latency percentiles: worker threads hammer their own timed hash table,
+    // queue and stack while a reporter dumps merged percentiles every 500 ms
+    {
+        LatencyReporter reporter(cout, chrono::milliseconds(500));
+        vector<thread> workers;
+        for (int w = 0; w < 4; w++) {
+            workers.emplace_back([w] {
+                Queue<int, LatencyRecorder> queue;
+                Stack<int, LatencyRecorder> stack;
+                BasicHashTable<NoInstrumentation, LatencyRecorder> table;
+                decltype(table)::PersonData found;
+                uint32_t state = 2463534242u + w;
+                for (int round = 0; round < 20000; round++) {
+                    int keys[8];
+                    for (int& key : keys) {
+                        state ^= state << 13;
+                        state ^= state >> 17;
+                        state ^= state << 5;
+                        key = int(state % 64);
+                        table.insert(key, { "Last", "First", "01-01-2024" });
+                        queue.enqueue(key);
+                        stack.push(key);
+                    }
+                    for (int key : keys) {
+                        table.lookup(key + 1, found);
+                        table.deleteKey(queue.dequeue());
+                        stack.pop();
+                    }
+                }
+            });
+        }
+        for (thread& worker : workers) worker.join();
+        reporter.stop();
+    }
+    cout << "Final latency percentiles:" << endl;
+    LatencyRecorder::report(cout);
+
+  separate();
+
+    // Request-scoped arena: one monotonic buffer serves the containers and
+    // scratch space below and is given back in one step. The upstream is
+    // null_memory_resource, which only catches the arena overflowing; memory
+    // that never asks the arena (like a std::string) still comes from the heap.
+    {
+        vector<std::byte> arenaStorage(size_t(1) << 20);
+        pmr::monotonic_buffer_resource arena(arenaStorage.data(), arenaStorage.size(), pmr::null_memory_resource());
+
+        GeneratorOptions requestOptions;
+        requestOptions.maximum_num = 1000000;
+        AlignedBuffer<int> requestData = DataGenerator::generate(2000, requestOptions, &arena);
+        SortingAlgorithms::mergeSort(requestData.data(), 2000, &arena);
+
+        pmr::vector<int> requestKeys = ArrayHelper::generateRandomArray(100, 0, 1000000, &arena);
+        LinkedList arenaList(&arena);
+        IndexedSkipList arenaSkipList(false, 0x9E3779B97F4A7C15ull, &arena);
+        for (int key : requestKeys) {
+            arenaList.insertAtEnd(key);
+            arenaSkipList.insert(key);
+        }
+
+        int requestTop[10];
+        SelectionAlgorithms::topK(requestData.data(), 2000, 10, requestTop, &arena);
+
+        HashTable arenaTable(&arena);
+        HashTable::PersonRecord arenaPerson(&arena);
+        arenaPerson.lastName = "A last name too long for SSO";
+        arenaPerson.firstName = "A first name too long for SSO";
+        arenaPerson.hireDate = "06-30-2024";
+        arenaTable.insert(201, arenaPerson);
+        HashTable::PersonRecord arenaFound(&arena);
+        arenaTable.lookup(201, arenaFound);
+
+        CompressedSortedArray arenaCompressed(requestData.data(), 2000, &arena);
+
+        cout << "Arena-backed request: sorted " << requestData.size() << " values ("
+             << (is_sorted(requestData.data(), requestData.data() + requestData.size()) ? "ok" : "not sorted")
+             << "), top value " << requestTop[0] << ", list and skip list of " << arenaSkipList.getLength()
+             << ", person " << arenaFound.firstName << ", compressed to " << arenaCompressed.memoryBytes() << " bytes" << endl;
+    }
+
+  separate();
+
+    // Compressed copy of the sorted sample-sort output: lookups and iteration
+    // decode a single 128-value block at a time
+    CompressedSortedArray compressed(fileData.data(), fileInts);
+    cout << "Compressed " << compressed.size() << " sorted ints: " << fileInts * sizeof(int) << " -> "
+         << compressed.memoryBytes() << " bytes" << endl;
+    for (int probeValue : { 0, 4242, 999999, 1000001 }) {
+        int plainIndex = SearchAlgorithms::binarySearch(fileData.data(), fileInts, probeValue);
+        int compressedIndex = compressed.find(probeValue);
+        cout << "find(" << probeValue << "): " << (compressedIndex != -1 ? "found" : "not found")
+             << ", binarySearch " << (plainIndex != -1 ? "found" : "not found")
+             << ", lowerBound " << compressed.lowerBound(probeValue) << endl;
+    }
+    cout << "Iteration matches the plain array: "
+         << (equal(compressed.begin(), compressed.end(), fileData.data()) ? "yes" : "no") << endl;
+
+  separate();
+
+    // Set operations on sorted id lists, e.g. people matching several filters
+    vector<int> filterA, filterB;
+    for (int id = 0; id < 3000; id += 3) filterA.push_back(id);
+    for (int id = 0; id < 3000; id += 5) filterB.push_back(id);
+    vector<int> filterC = { 15, 30, 450, 1000, 2985 };
+    vector<int> setResult(filterA.size() + filterB.size());
+
+    int matched = SetOperations::intersect(filterA.data(), int(filterA.size()), filterB.data(), int(filterB.size()), setResult.data());
+    cout << "Ids in both filters: " << matched << endl;
+    int either = SetOperations::unite(filterA.data(), int(filterA.size()), filterB.data(), int(filterB.size()), setResult.data());
+    cout << "Ids in either filter: " << either << endl;
+    int onlyA = SetOperations::difference(filterA.data(), int(filterA.size()), filterB.data(), int(filterB.size()), setResult.data());
+    cout << "Ids only in the first filter: " << onlyA << endl;
+    int all = SetOperations::intersectMany({ span<const int>(filterA), span<const int>(filterB), span<const int>(filterC) }, setResult.data());
+    cout << "Ids in all three filters: ";
+    ArrayHelper::printArray(setResult.data(), all);
+
   return 0;
 }